@@ -18,12 +18,26 @@
 
 /*  Keil::Device:StdPeriph Drivers:Framework:3.5.1 */
 #define RTE_DEVICE_STDPERIPH_FRAMEWORK
+/*  Keil::Device:StdPeriph Drivers:ADC:3.5.0 */
+#define RTE_DEVICE_STDPERIPH_ADC
+/*  Keil::Device:StdPeriph Drivers:BKP:3.5.0 */
+#define RTE_DEVICE_STDPERIPH_BKP
+/*  Keil::Device:StdPeriph Drivers:DMA:3.5.0 */
+#define RTE_DEVICE_STDPERIPH_DMA
 /*  Keil::Device:StdPeriph Drivers:GPIO:3.5.0 */
 #define RTE_DEVICE_STDPERIPH_GPIO
 /*  Keil::Device:StdPeriph Drivers:I2C:3.5.0 */
 #define RTE_DEVICE_STDPERIPH_I2C
+/*  Keil::Device:StdPeriph Drivers:PWR:3.5.0 */
+#define RTE_DEVICE_STDPERIPH_PWR
 /*  Keil::Device:StdPeriph Drivers:RCC:3.5.0 */
 #define RTE_DEVICE_STDPERIPH_RCC
+/*  Keil::Device:StdPeriph Drivers:RTC:3.5.0 */
+#define RTE_DEVICE_STDPERIPH_RTC
+/*  Keil::Device:StdPeriph Drivers:TIM:3.5.0 */
+#define RTE_DEVICE_STDPERIPH_TIM
+/*  Keil::Device:StdPeriph Drivers:USART:3.5.0 */
+#define RTE_DEVICE_STDPERIPH_USART
 
 
 #endif /* RTE_COMPONENTS_H */
@@ -0,0 +1,173 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "adc.h"
+#include "ds3231.h"
+
+#include "RTE_Components.h"
+#include CMSIS_device_header
+
+/*******************************************************************/
+// DMA fills one half while the other one is summed up
+static uint16_t adc_buf[2][ADC_HALF_SCANS][ADC_SCAN_CH];
+
+// Sums since the last ADC_take, touched by the DMA interrupt only
+static uint32_t adc_acc[ADC_CH_CNT];
+static uint16_t adc_cnt = 0;
+
+// Temperature sensor, only summed up during a conversion
+static volatile bool adc_temp_req = false;
+static bool adc_temp_run = false;
+static uint32_t adc_temp_acc;
+static uint16_t adc_temp_cnt;
+
+/*******************************************************************/
+void ADC_init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+    DMA_InitTypeDef  DMA_InitStructure;
+    ADC_InitTypeDef  ADC_InitStructure;
+
+    RCC_ADCCLKConfig(RCC_PCLK2_Div6);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_ADC1 | RCC_APB2Periph_GPIOA, ENABLE);
+
+    /* AIN0...AIN3 */
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_0 | GPIO_Pin_1 | GPIO_Pin_2 | GPIO_Pin_3;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AIN;
+    GPIO_Init(GPIOA, &GPIO_InitStructure);
+
+    /* ADC1 -> adc_buf, circular, interrupt on each half */
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&ADC1->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)adc_buf;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = sizeof(adc_buf) / sizeof(adc_buf[0][0][0]);
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel1, &DMA_InitStructure);
+    DMA_ITConfig(DMA1_Channel1, DMA_IT_HT | DMA_IT_TC, ENABLE);
+    DMA_Cmd(DMA1_Channel1, ENABLE);
+
+    /* Below the I2C interrupts */
+    NVIC_InitStructure.NVIC_IRQChannel                   = DMA1_Channel1_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 2;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority        = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd                = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+
+    /* Continuous scan of all channels */
+    ADC_InitStructure.ADC_Mode = ADC_Mode_Independent;
+    ADC_InitStructure.ADC_ScanConvMode = ENABLE;
+    ADC_InitStructure.ADC_ContinuousConvMode = ENABLE;
+    ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_None;
+    ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
+    ADC_InitStructure.ADC_NbrOfChannel = ADC_SCAN_CH;
+    ADC_Init(ADC1, &ADC_InitStructure);
+
+    ADC_RegularChannelConfig(ADC1, ADC_Channel_0, 1, ADC_SampleTime_239Cycles5);
+    ADC_RegularChannelConfig(ADC1, ADC_Channel_1, 2, ADC_SampleTime_239Cycles5);
+    ADC_RegularChannelConfig(ADC1, ADC_Channel_2, 3, ADC_SampleTime_239Cycles5);
+    ADC_RegularChannelConfig(ADC1, ADC_Channel_3, 4, ADC_SampleTime_239Cycles5);
+    // The sensor needs 17.1 us sampling time, 239.5 cycles are 20 us
+    ADC_RegularChannelConfig(ADC1, ADC_Channel_TempSensor, 5, ADC_SampleTime_239Cycles5);
+    ADC_TempSensorVrefintCmd(ENABLE);
+
+    ADC_DMACmd(ADC1, ENABLE);
+    ADC_Cmd(ADC1, ENABLE);
+
+    ADC_ResetCalibration(ADC1);
+    while (ADC_GetResetCalibrationStatus(ADC1));
+    ADC_StartCalibration(ADC1);
+    while (ADC_GetCalibrationStatus(ADC1));
+
+    ADC_SoftwareStartConvCmd(ADC1, ENABLE);
+}
+
+/*******************************************************************/
+// Drops the sums, callable from below the DMA interrupt level
+void ADC_restart(void)
+{
+    uint32_t sum[ADC_CH_CNT];
+
+    NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+    ADC_take(sum);
+    NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+}
+
+// Takes the sums and restarts them, returns the number of scans summed up.
+// Must not be preempted by the DMA interrupt.
+uint16_t ADC_take(uint32_t sum[ADC_CH_CNT])
+{
+    uint16_t cnt = adc_cnt;
+
+    memcpy(sum, adc_acc, sizeof(adc_acc));
+    memset(adc_acc, 0, sizeof(adc_acc));
+    adc_cnt = 0;
+
+    return cnt;
+}
+
+// Starts a temperature conversion, DS3231_temp gets the result
+void ADC_temp_start(void)
+{
+    adc_temp_req = true;
+}
+
+/*******************************************************************/
+void DMA1_Channel1_IRQHandler(void)
+{
+    uint16_t (*half)[ADC_SCAN_CH];
+
+    if (DMA_GetITStatus(DMA1_IT_HT1))
+    {
+        DMA_ClearITPendingBit(DMA1_IT_HT1);
+        half = adc_buf[0];
+    }
+    else
+    {
+        DMA_ClearITPendingBit(DMA1_IT_TC1);
+        half = adc_buf[1];
+    }
+
+    // Oversampling: plain sums, decimation is done on the result
+    for (uint8_t i = 0; i < ADC_HALF_SCANS; i++)
+    {
+        for (uint8_t ch = 0; ch < ADC_CH_CNT; ch++)
+        {
+            adc_acc[ch] += half[i][ch];
+        }
+    }
+    adc_cnt += ADC_HALF_SCANS;
+
+    if (adc_temp_req)
+    {
+        adc_temp_req = false;
+        adc_temp_run = true;
+        adc_temp_acc = 0;
+        adc_temp_cnt = 0;
+    }
+
+    if (adc_temp_run)
+    {
+        for (uint8_t i = 0; i < ADC_HALF_SCANS; i++)
+        {
+            adc_temp_acc += half[i][ADC_CH_TEMP];
+        }
+        adc_temp_cnt += ADC_HALF_SCANS;
+
+        if (adc_temp_cnt >= ADC_TEMP_SCANS)
+        {
+            adc_temp_run = false;
+            // Mean in 1/16 ADC steps
+            DS3231_temp(adc_temp_acc * 16 / adc_temp_cnt);
+        }
+    }
+}
+
+/*******************************************************************/
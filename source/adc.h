@@ -0,0 +1,26 @@
+// ADC1 continuous scan of the ADS1115 inputs and the internal temperature
+// sensor (DS3231 temperature) with DMA into a double buffer
+
+#ifndef ADC_H
+#define ADC_H
+
+#include <stdint.h>
+
+/*******************************************************************/
+#define ADC_CH_CNT              4      // AIN0...AIN3 on PA0...PA3
+#define ADC_CH_TEMP             ADC_CH_CNT // Temperature sensor, last in the scan
+#define ADC_SCAN_CH             (ADC_CH_CNT + 1)
+#define ADC_HALF_SCANS          4      // Scans per half of the DMA buffer
+// ADCCLK 12 MHz, 239.5 + 12.5 cycles per conversion: 9.5 kHz scan rate
+#define ADC_TEMP_SCANS          1024   // Temperature conversion (~110 ms)
+
+/*******************************************************************/
+
+void ADC_init(void);
+void ADC_restart(void);
+uint16_t ADC_take(uint32_t sum[ADC_CH_CNT]);
+void ADC_temp_start(void);
+
+#endif // ADC_H
+
+/*******************************************************************/
@@ -0,0 +1,418 @@
+#include <stdbool.h>
+
+#include "ads1115.h"
+#include "adc.h"
+
+#include "RTE_Components.h"
+#include CMSIS_device_header
+
+/*******************************************************************/
+#define ADS1115_MSB(val)        (uint8_t)((val) >> 8)
+#define ADS1115_LSB(val)        (uint8_t)(val)
+
+// Byte address of the 16 bit register in the bank
+#define ADS1115_ADR(reg)        ((reg) << 1)
+
+#define ADS1115_GND             0xFF   // Negative input is ground
+
+// ALERT/RDY output, open-drain like the device
+#define ADS1115_ALERT_PORT      GPIOA
+#define ADS1115_ALERT_PIN       GPIO_Pin_8
+
+/*******************************************************************/
+// Side effects of register writes, run by the main loop
+enum
+{
+    ADS1115_HOOK_CONFIG = 1,
+    ADS1115_HOOK_THRESH,
+};
+
+// Register map: byte address, reset value, writable bits, clear-on-write-0 bits,
+// hook. The conversion register is read-only and OS is a status bit on read,
+// writing 1 starts a conversion (the hook sees the written value).
+#define ADS1115_REGS(REG)                                                                  \
+    REG(ADS1115_ADR(ADS1115_REG_CONVERSION),     0x00, 0x00, 0x00, I2C1_HOOK_NONE)         \
+    REG(ADS1115_ADR(ADS1115_REG_CONVERSION) + 1, 0x00, 0x00, 0x00, I2C1_HOOK_NONE)         \
+    REG(ADS1115_ADR(ADS1115_REG_CONFIG),                                                   \
+        ADS1115_MSB(ADS1115_CONFIG_DEFAULT), 0x7F, 0x00, ADS1115_HOOK_CONFIG)              \
+    REG(ADS1115_ADR(ADS1115_REG_CONFIG) + 1,                                               \
+        ADS1115_LSB(ADS1115_CONFIG_DEFAULT), 0xFF, 0x00, ADS1115_HOOK_CONFIG)              \
+    REG(ADS1115_ADR(ADS1115_REG_LO_THRESH),                                                \
+        ADS1115_MSB(ADS1115_LO_DEFAULT), 0xFF, 0x00, ADS1115_HOOK_THRESH)                  \
+    REG(ADS1115_ADR(ADS1115_REG_LO_THRESH) + 1,                                            \
+        ADS1115_LSB(ADS1115_LO_DEFAULT), 0xFF, 0x00, ADS1115_HOOK_THRESH)                  \
+    REG(ADS1115_ADR(ADS1115_REG_HI_THRESH),                                                \
+        ADS1115_MSB(ADS1115_HI_DEFAULT), 0xFF, 0x00, ADS1115_HOOK_THRESH)                  \
+    REG(ADS1115_ADR(ADS1115_REG_HI_THRESH) + 1,                                            \
+        ADS1115_LSB(ADS1115_HI_DEFAULT), 0xFF, 0x00, ADS1115_HOOK_THRESH)
+
+const I2C1_REG_t ads1115_reg[ADS1115_RAM_SIZE] =
+{
+    ADS1115_REGS(I2C1_REG_DESC)
+};
+I2C1_REG_CHECK(ads1115_reg, ADS1115_REGS, ADS1115_RAM_SIZE);
+
+uint8_t ads1115_ram[ADS1115_RAM_SIZE];
+
+// Config in effect without OS, replaced as a whole at the STOP of a write
+static volatile uint16_t ads1115_cfg = ADS1115_CONFIG_DEFAULT & ~ADS1115_CONFIG_OS;
+// Config being written by the master, main loop only
+static uint16_t ads1115_cfg_wr = ADS1115_CONFIG_DEFAULT & ~ADS1115_CONFIG_OS;
+static bool ads1115_cfg_dirty = false;
+static bool ads1115_os_wr = false;
+
+// Conversion in progress, OS reads 0
+static volatile bool ads1115_busy = false;
+
+// Last conversion result, published with a single 16 bit store
+static volatile uint16_t ads1115_conv = 0;
+
+// Thresholds in effect, replaced at the STOP of a write
+static volatile int16_t ads1115_lo = (int16_t)ADS1115_LO_DEFAULT;
+static volatile int16_t ads1115_hi = (int16_t)ADS1115_HI_DEFAULT;
+static bool ads1115_thresh_dirty = false;
+
+// Comparator state, TIM2 interrupt only
+static bool ads1115_alert_on = false;
+static uint8_t ads1115_alert_cnt = 0;
+// Conversion register read by the master, clears a latched ALERT
+static volatile bool ads1115_alert_ack = false;
+
+// Inputs of the MUX[2:0] settings: positive, negative
+static const uint8_t ads1115_mux[8][2] =
+{
+    {0, 1}, {0, 3}, {1, 3}, {2, 3},
+    {0, ADS1115_GND}, {1, ADS1115_GND}, {2, ADS1115_GND}, {3, ADS1115_GND},
+};
+
+// Code per 12 bit ADC step (3.3 V) of the PGA[2:0] settings in Q8:
+// 3300 mV * 32768 / 4096 / FSR mV * 256
+static const uint16_t ads1115_gain[8] =
+{
+    1100,   // +-6.144 V
+    1650,   // +-4.096 V
+    3300,   // +-2.048 V
+    6600,   // +-1.024 V
+    13200,  // +-0.512 V
+    26400,  // +-0.256 V
+    26400,
+    26400,
+};
+
+/*******************************************************************/
+// ALERT/RDY pin, active low unless COMP_POL is set
+static void ads1115_alert(bool on)
+{
+    ads1115_alert_on = on;
+
+    if (on == ((ads1115_cfg & ADS1115_CONFIG_COMP_POL) != 0))
+    {
+        ADS1115_ALERT_PORT->BSRR = ADS1115_ALERT_PIN;
+    }
+    else
+    {
+        ADS1115_ALERT_PORT->BRR = ADS1115_ALERT_PIN;
+    }
+}
+
+// Conversion ready mode: MSB of Hi_thresh set, MSB of Lo_thresh cleared
+static bool ads1115_rdy_mode(void)
+{
+    return (ads1115_hi < 0) && (ads1115_lo >= 0);
+}
+
+// Comparator after each conversion
+static void ads1115_compare(int16_t conv)
+{
+    uint16_t cfg = ads1115_cfg;
+    uint8_t que = cfg & ADS1115_CONFIG_COMP_QUE;
+    bool out;
+
+    if (ads1115_alert_ack)
+    {
+        ads1115_alert_ack = false;
+        if (cfg & ADS1115_CONFIG_COMP_LAT)
+        {
+            ads1115_alert_cnt = 0;
+            ads1115_alert(false);
+        }
+    }
+
+    if (que == ADS1115_CONFIG_COMP_QUE)
+    {
+        // Comparator disabled, pin released
+        return;
+    }
+
+    if (ads1115_rdy_mode())
+    {
+        // Continuous mode: pulse, ended by the compare channel
+        ads1115_alert(true);
+        return;
+    }
+
+    if (cfg & ADS1115_CONFIG_COMP_MODE)
+    {
+        out = (conv > ads1115_hi) || (conv < ads1115_lo);
+    }
+    else
+    {
+        out = conv > ads1115_hi;
+    }
+
+    if (!out)
+    {
+        ads1115_alert_cnt = 0;
+
+        // Non-latching: the window, or below Lo_thresh for the hysteresis
+        if (!(cfg & ADS1115_CONFIG_COMP_LAT)
+            && ((cfg & ADS1115_CONFIG_COMP_MODE) || conv < ads1115_lo))
+        {
+            ads1115_alert(false);
+        }
+    }
+    else if (++ads1115_alert_cnt >= (1 << que))
+    {
+        ads1115_alert_cnt = 1 << que;
+        ads1115_alert(true);
+    }
+}
+
+/*******************************************************************/
+// Conversion period of the data rate on TIM2 (clocked with HCLK), see
+// ADS1115_rate_cfg
+static void ads1115_rate(uint16_t cfg)
+{
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+    ADS1115_RATE_t rate;
+
+    ADS1115_rate_cfg(cfg, SystemCoreClock, &rate);
+
+    TIM_TimeBaseStructure.TIM_Prescaler = rate.psc;
+    TIM_TimeBaseStructure.TIM_Period = rate.period;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+    TIM_TimeBaseInit(TIM2, &TIM_TimeBaseStructure);
+
+    // End of the conversion ready pulse
+    TIM_SetCompare1(TIM2, rate.pulse);
+
+    // TIM_TimeBaseInit generates an update event to load the prescaler
+    TIM_ClearITPendingBit(TIM2, TIM_IT_Update);
+}
+
+// New config from the master, start marks OS written as 1
+static void ads1115_apply(uint16_t cfg, bool start)
+{
+    bool single = (cfg & ADS1115_CONFIG_MODE) != 0;
+
+    TIM_Cmd(TIM2, DISABLE);
+    // The comparator state belongs to the TIM2 interrupt
+    NVIC_DisableIRQ(TIM2_IRQn);
+
+    ads1115_cfg = cfg;
+    ads1115_rate(cfg);
+
+    // New settings restart the comparator, a new conversion ends RDY
+    ads1115_alert_cnt = 0;
+    ads1115_alert_ack = false;
+    ads1115_alert(false);
+
+    // Single-shot: OS = 1 starts one conversion from power-down
+    if (!single || start || ads1115_busy)
+    {
+        ads1115_busy = true;
+        TIM_SelectOnePulseMode(TIM2, single ? TIM_OPMode_Single : TIM_OPMode_Repetitive);
+        // The conversion integrates the inputs from now on
+        ADC_restart();
+        TIM_Cmd(TIM2, ENABLE);
+    }
+
+    NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+/*******************************************************************/
+void ADS1115_init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+
+    for (uint8_t i = 0; i < ADS1115_RAM_SIZE; i++)
+    {
+        ads1115_ram[i] = ads1115_reg[i].reset;
+    }
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA, ENABLE);
+
+    /* ALERT/RDY, released */
+    ADS1115_ALERT_PORT->BSRR = ADS1115_ALERT_PIN;
+    GPIO_InitStructure.GPIO_Pin = ADS1115_ALERT_PIN;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_2MHz;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_OD;
+    GPIO_Init(ADS1115_ALERT_PORT, &GPIO_InitStructure);
+
+    ads1115_rate(ads1115_cfg);
+    TIM_ITConfig(TIM2, TIM_IT_Update | TIM_IT_CC1, ENABLE);
+
+    /* Same level as the ADC DMA interrupt, so they never preempt each other */
+    NVIC_InitStructure.NVIC_IRQChannel                   = TIM2_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 2;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority        = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd                = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+
+    ADC_init();
+}
+
+/*******************************************************************/
+// START with own address: latch the last result into the conversion register
+void ADS1115_start(bool read)
+{
+    uint16_t conv = ads1115_conv;
+    uint8_t *cfg = &ads1115_ram[ADS1115_ADR(ADS1115_REG_CONFIG)];
+
+    ads1115_ram[ADS1115_ADR(ADS1115_REG_CONVERSION)] = ADS1115_MSB(conv);
+    ads1115_ram[ADS1115_ADR(ADS1115_REG_CONVERSION) + 1] = ADS1115_LSB(conv);
+
+    // The bank is only written with the I2C event interrupt masked (here
+    // or by the commit), so OS is merged in here
+    *cfg = ads1115_busy
+           ? *cfg & ~ADS1115_MSB(ADS1115_CONFIG_OS)
+           : *cfg | ADS1115_MSB(ADS1115_CONFIG_OS);
+
+    // Reading the result releases a latched ALERT, in the TIM2 interrupt
+    if (read && i2c1_bank[I2C1_DEV_ADS1115].adr == ADS1115_ADR(ADS1115_REG_CONVERSION)
+        && ads1115_alert_on)
+    {
+        ads1115_alert_ack = true;
+        NVIC_SetPendingIRQ(TIM2_IRQn);
+    }
+}
+
+/*******************************************************************/
+// Register write side effects, called by the main loop
+void ADS1115_event(const EVQ_ITEM_t *item)
+{
+    if (item->adr == EVQ_ADR_STOP)
+    {
+        if (ads1115_thresh_dirty)
+        {
+            // The bank holds the complete registers at the STOP. Like the
+            // device the conversions and the comparator state keep running,
+            // only the next comparison uses the new pair.
+            ads1115_thresh_dirty = false;
+            NVIC_DisableIRQ(TIM2_IRQn);
+            ads1115_lo = (int16_t)((ads1115_ram[ADS1115_ADR(ADS1115_REG_LO_THRESH)] << 8)
+                                   | ads1115_ram[ADS1115_ADR(ADS1115_REG_LO_THRESH) + 1]);
+            ads1115_hi = (int16_t)((ads1115_ram[ADS1115_ADR(ADS1115_REG_HI_THRESH)] << 8)
+                                   | ads1115_ram[ADS1115_ADR(ADS1115_REG_HI_THRESH) + 1]);
+            NVIC_EnableIRQ(TIM2_IRQn);
+        }
+
+        if (ads1115_cfg_dirty)
+        {
+            ads1115_cfg_dirty = false;
+            ads1115_apply(ads1115_cfg_wr, ads1115_os_wr);
+            ads1115_os_wr = false;
+        }
+        return;
+    }
+
+    switch (ads1115_reg[item->adr].hook)
+    {
+    case ADS1115_HOOK_CONFIG:
+        if (item->adr == ADS1115_ADR(ADS1115_REG_CONFIG))
+        {
+            ads1115_os_wr = (item->val & ADS1115_MSB(ADS1115_CONFIG_OS)) != 0;
+            ads1115_cfg_wr = (ads1115_cfg_wr & 0x00FF) | ((item->val << 8) & ~ADS1115_CONFIG_OS);
+        }
+        else
+        {
+            ads1115_cfg_wr = (ads1115_cfg_wr & 0xFF00) | item->val;
+        }
+        ads1115_cfg_dirty = true;
+        break;
+
+    case ADS1115_HOOK_THRESH:
+        ads1115_thresh_dirty = true;
+        break;
+    }
+}
+
+/*******************************************************************/
+// Decimation of the oversampled ADC sums into a 16 bit code, runs below
+// the I2C interrupts so the I2C path only copies the result
+static int16_t ads1115_convert(void)
+{
+    uint32_t sum[ADC_CH_CNT];
+    uint16_t cfg = ads1115_cfg;
+    const uint8_t *mux = ads1115_mux[(cfg >> ADS1115_CONFIG_MUX_Pos) & 0x07];
+    uint16_t cnt = ADC_take(sum);
+    int32_t diff;
+    int32_t code;
+
+    if (cnt == 0)
+    {
+        return (int16_t)ads1115_conv;
+    }
+
+    diff = sum[mux[0]];
+    if (mux[1] != ADS1115_GND)
+    {
+        diff -= sum[mux[1]];
+    }
+
+    // Mean in 1/16 ADC steps keeps the oversampled resolution
+    code = diff * 16 / cnt;
+    code = (code * ads1115_gain[(cfg >> ADS1115_CONFIG_PGA_Pos) & 0x07]) >> 12;
+
+    if (code > INT16_MAX) code = INT16_MAX;
+    if (code < INT16_MIN) code = INT16_MIN;
+
+    ads1115_conv = (uint16_t)code;
+
+    return (int16_t)code;
+}
+
+/*******************************************************************/
+// End of a conversion period at the configured data rate
+void TIM2_IRQHandler(void)
+{
+    if (TIM_GetITStatus(TIM2, TIM_IT_CC1) != RESET)
+    {
+        TIM_ClearITPendingBit(TIM2, TIM_IT_CC1);
+
+        // End of the conversion ready pulse in continuous mode
+        if (ads1115_rdy_mode() && !(ads1115_cfg & ADS1115_CONFIG_MODE))
+        {
+            ads1115_alert(false);
+        }
+    }
+
+    if (TIM_GetITStatus(TIM2, TIM_IT_Update) != RESET)
+    {
+        TIM_ClearITPendingBit(TIM2, TIM_IT_Update);
+
+        ads1115_compare(ads1115_convert());
+
+        // One-pulse mode has stopped the timer after a single-shot conversion
+        if (ads1115_cfg & ADS1115_CONFIG_MODE)
+        {
+            ads1115_busy = false;
+        }
+    }
+    else if (ads1115_alert_ack)
+    {
+        // Pended by the I2C interrupt
+        ads1115_alert_ack = false;
+        if ((ads1115_cfg & ADS1115_CONFIG_COMP_LAT) && !ads1115_rdy_mode())
+        {
+            ads1115_alert_cnt = 0;
+            ads1115_alert(false);
+        }
+    }
+}
+
+/*******************************************************************/
@@ -0,0 +1,60 @@
+// ADS1115 register model
+// see: https://www.ti.com/lit/ds/symlink/ads1115.pdf
+
+#ifndef ADS1115_H
+#define ADS1115_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "event_queue.h"
+#include "i2c_slave.h"
+
+/*******************************************************************/
+#define ADS1115_RAM_SIZE        0x08   // 4 x 16 bit registers, MSB first
+
+// Register pointer (2 bits), byte address in the bank is pointer * 2
+#define ADS1115_REG_CONVERSION  0x00
+#define ADS1115_REG_CONFIG      0x01
+#define ADS1115_REG_LO_THRESH   0x02
+#define ADS1115_REG_HI_THRESH   0x03
+#define ADS1115_PTR_MASK        0x03
+
+// Config register bits
+#define ADS1115_CONFIG_OS       0x8000 // Conversion start / not busy
+#define ADS1115_CONFIG_MUX_Pos  12
+#define ADS1115_CONFIG_PGA_Pos  9
+#define ADS1115_CONFIG_MODE     0x0100 // Single-shot / power-down
+#define ADS1115_CONFIG_DR_Pos   5
+#define ADS1115_CONFIG_COMP_MODE 0x0010 // Window comparator
+#define ADS1115_CONFIG_COMP_POL 0x0008 // ALERT/RDY active high
+#define ADS1115_CONFIG_COMP_LAT 0x0004 // Latching comparator
+#define ADS1115_CONFIG_COMP_QUE 0x0003 // Assert after 1, 2, 4 conversions, 3: disable
+#define ADS1115_CONFIG_DEFAULT  0x8583
+#define ADS1115_LO_DEFAULT      0x8000
+#define ADS1115_HI_DEFAULT      0x7FFF
+
+#define ADS1115_RDY_PULSE       125000 // 1 / 8 us conversion ready pulse
+
+// TIM2 settings of the conversion cadence
+typedef struct
+{
+    uint16_t psc;           // TIM_Prescaler
+    uint16_t period;        // TIM_Period, one conversion
+    uint16_t pulse;         // Compare 1, end of the conversion ready pulse
+} ADS1115_RATE_t;
+
+/*******************************************************************/
+
+extern uint8_t ads1115_ram[ADS1115_RAM_SIZE];
+extern const I2C1_REG_t ads1115_reg[ADS1115_RAM_SIZE];
+
+void ADS1115_init(void);
+void ADS1115_start(bool read);
+void ADS1115_event(const EVQ_ITEM_t *item);
+uint16_t ADS1115_sps(uint16_t cfg);
+void ADS1115_rate_cfg(uint16_t cfg, uint32_t clock, ADS1115_RATE_t *rate);
+
+#endif // ADS1115_H
+
+/*******************************************************************/
@@ -0,0 +1,27 @@
+#include "ads1115.h"
+
+/*******************************************************************/
+// Data rates of the DR[2:0] settings in SPS
+static const uint16_t ads1115_sps[8] = {8, 16, 32, 64, 128, 250, 475, 860};
+
+/*******************************************************************/
+// Data rate of a config register value in SPS
+uint16_t ADS1115_sps(uint16_t cfg)
+{
+    return ads1115_sps[(cfg >> ADS1115_CONFIG_DR_Pos) & 0x07];
+}
+
+// Timer settings of the conversion cadence from the timer clock, the
+// prescaler is the smallest one that lets the period fit into 16 bit; no
+// hardware access so it also builds on the host
+void ADS1115_rate_cfg(uint16_t cfg, uint32_t clock, ADS1115_RATE_t *rate)
+{
+    uint32_t ticks = clock / ADS1115_sps(cfg);
+    uint32_t psc = ticks / 0x10000 + 1;
+
+    rate->psc = psc - 1;
+    rate->period = ticks / psc - 1;
+    rate->pulse = clock / ADS1115_RDY_PULSE / psc + 1;
+}
+
+/*******************************************************************/
@@ -0,0 +1,83 @@
+#include "calendar.h"
+
+/*******************************************************************/
+// Divisions by constants as multiply and shift, (n * M) >> S is exact for
+// the whole range of n noted, checked exhaustively on the host
+#define CALENDAR_DIV10(n)       (((uint32_t)(n) * 205) >> 11)       // n < 256
+#define CALENDAR_DIV5(n)        (((uint32_t)(n) * 1639) >> 13)      // n < 1686
+#define CALENDAR_DIV153(n)      (((uint32_t)(n) * 857) >> 17)       // n < 1828
+#define CALENDAR_DIV365(n)      (((uint32_t)(n) * 1437) >> 19)      // n < 1461
+#define CALENDAR_DIV1461(n)     (((uint32_t)(n) * 22967) >> 25)     // n < 80000
+#define CALENDAR_DIV60(n)       (((uint32_t)(n) * 2185) >> 17)      // n < 3600
+#define CALENDAR_DIV3600(n)     (((uint32_t)(n) * 37283) >> 27)     // n < 86400
+#define CALENDAR_DIV7(n)        ((uint32_t)(((uint64_t)(n) * 74899) >> 19))         // n < 80000
+#define CALENDAR_DIV86400(n)    ((uint32_t)(((uint64_t)(n) * 3257812231u) >> 48))   // all n
+
+// Day 0 is 01.01. of year 0. The count runs from 01.03. of year -4, so the
+// leap day is the last day of every 4th March based year.
+#define CALENDAR_DAY0           1401   // 4 * 365 + 1 - 31 - 29
+
+/*******************************************************************/
+uint8_t CALENDAR_bcd2bin(uint8_t bcd)
+{
+    return bcd - 6 * (bcd >> 4);
+}
+
+uint8_t CALENDAR_bin2bcd(uint8_t bin)
+{
+    return bin + 6 * CALENDAR_DIV10(bin);
+}
+
+/*******************************************************************/
+// Days since 01.01.00 of a binary date, month 1...12
+uint32_t CALENDAR_days(uint8_t year, uint8_t month, uint8_t date)
+{
+    uint32_t y = year + 4 - (month <= 2);
+    uint32_t mp = (month > 2) ? month - 3 : month + 9;
+
+    return y * 365 + (y >> 2) + CALENDAR_DIV5(153 * mp + 2) + date - 1 - CALENDAR_DAY0;
+}
+
+// Binary date of the days since 01.01.00, days < CALENDAR_YEARS * 365.25
+void CALENDAR_date(uint32_t days, uint8_t *year, uint8_t *month, uint8_t *date)
+{
+    uint32_t z = days + CALENDAR_DAY0;
+    uint32_t cycle = CALENDAR_DIV1461(z);
+    uint32_t doe = z - cycle * 1461;
+    // The leap day closes the cycle
+    uint32_t yoe = CALENDAR_DIV365(doe - (doe == 1460));
+    uint32_t doy = doe - yoe * 365;
+    uint32_t mp = CALENDAR_DIV153(5 * doy + 2);
+
+    *date = doy - CALENDAR_DIV5(153 * mp + 2) + 1;
+    *month = (mp < 10) ? mp + 3 : mp - 9;
+    *year = cycle * 4 + yoe - 4 + (*month <= 2);
+}
+
+// Days modulo 7, 01.01.00 is 0
+uint8_t CALENDAR_weekday(uint32_t days)
+{
+    return days - 7 * CALENDAR_DIV7(days);
+}
+
+/*******************************************************************/
+// Whole days of a second count, hms is the rest in binary seconds, minutes,
+// hours (the order of the DS3231 registers)
+uint32_t CALENDAR_split(uint32_t sec, uint8_t *hms)
+{
+    uint32_t days = CALENDAR_DIV86400(sec);
+    uint32_t rem = sec - days * 86400;
+    uint32_t hours = CALENDAR_DIV3600(rem);
+    uint32_t min;
+
+    rem -= hours * 3600;
+    min = CALENDAR_DIV60(rem);
+
+    hms[0] = rem - min * 60;
+    hms[1] = min;
+    hms[2] = hours;
+
+    return days;
+}
+
+/*******************************************************************/
@@ -0,0 +1,28 @@
+// Conversion between the DS3231 calendar and linear day and second counts
+// without divisions (days from civil with March based years), usable by the
+// firmware and on the host. Years are binary 0...199: the year register
+// plus 100 with the century bit. Every 4th year is a leap year like in the
+// DS3231, so 2100 is one as well.
+
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <stdint.h>
+
+/*******************************************************************/
+#define CALENDAR_YEARS          200    // Year range, days fit in 17 bit
+
+/*******************************************************************/
+
+uint8_t CALENDAR_bcd2bin(uint8_t bcd);
+uint8_t CALENDAR_bin2bcd(uint8_t bin);
+
+uint32_t CALENDAR_days(uint8_t year, uint8_t month, uint8_t date);
+void CALENDAR_date(uint32_t days, uint8_t *year, uint8_t *month, uint8_t *date);
+uint8_t CALENDAR_weekday(uint32_t days);
+
+uint32_t CALENDAR_split(uint32_t sec, uint8_t *hms);
+
+#endif // CALENDAR_H
+
+/*******************************************************************/
@@ -0,0 +1,723 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "ds3231.h"
+#include "adc.h"
+#include "calendar.h"
+
+#include "RTE_Components.h"
+#include CMSIS_device_header
+
+/*******************************************************************/
+// Side effects of register writes, run by the main loop
+enum
+{
+    DS3231_HOOK_TIME = 1,
+    DS3231_HOOK_ALARM,
+    DS3231_HOOK_CONTROL,
+    DS3231_HOOK_STATUS,
+    DS3231_HOOK_AGING,
+};
+
+// Register map: address, reset value, writable bits, clear-on-write-0 bits, hook
+// Power-on time is 01.01.00, day 1, 00:00:00
+#define DS3231_REGS(REG)                                                                  \
+    REG(DS3231_REG_SECONDS,     0x00, 0x7F, 0x00, DS3231_HOOK_TIME)                       \
+    REG(DS3231_REG_MINUTES,     0x00, 0x7F, 0x00, DS3231_HOOK_TIME)                       \
+    REG(DS3231_REG_HOURS,       0x00, 0x7F, 0x00, DS3231_HOOK_TIME)                       \
+    REG(DS3231_REG_DAY,         0x01, 0x07, 0x00, DS3231_HOOK_TIME)                       \
+    REG(DS3231_REG_DATE,        0x01, 0x3F, 0x00, DS3231_HOOK_TIME)                       \
+    REG(DS3231_REG_MONTH,       0x01, 0x9F, 0x00, DS3231_HOOK_TIME)                       \
+    REG(DS3231_REG_YEAR,        0x00, 0xFF, 0x00, DS3231_HOOK_TIME)                       \
+    REG(DS3231_REG_A1_SECONDS,  0x00, 0xFF, 0x00, DS3231_HOOK_ALARM)                      \
+    REG(DS3231_REG_A1_MINUTES,  0x00, 0xFF, 0x00, DS3231_HOOK_ALARM)                      \
+    REG(DS3231_REG_A1_HOURS,    0x00, 0xFF, 0x00, DS3231_HOOK_ALARM)                      \
+    REG(DS3231_REG_A1_DAY_DATE, 0x00, 0xFF, 0x00, DS3231_HOOK_ALARM)                      \
+    REG(DS3231_REG_A2_MINUTES,  0x00, 0xFF, 0x00, DS3231_HOOK_ALARM)                      \
+    REG(DS3231_REG_A2_HOURS,    0x00, 0xFF, 0x00, DS3231_HOOK_ALARM)                      \
+    REG(DS3231_REG_A2_DAY_DATE, 0x00, 0xFF, 0x00, DS3231_HOOK_ALARM)                      \
+    /* INTCN, RS2, RS1 */                                                                 \
+    REG(DS3231_REG_CONTROL,     0x1C, 0xFF, 0x00, DS3231_HOOK_CONTROL)                    \
+    /* OSF, EN32kHz; BSY is read-only, OSF and the alarm flags can only be cleared */     \
+    REG(DS3231_REG_STATUS,      0x88, DS3231_STATUS_EN32KHZ,                              \
+        DS3231_STATUS_OSF | DS3231_STATUS_A2F | DS3231_STATUS_A1F, DS3231_HOOK_STATUS)    \
+    REG(DS3231_REG_AGING,       0x00, 0xFF, 0x00, DS3231_HOOK_AGING)                      \
+    REG(DS3231_REG_TEMP_MSB,    0x00, 0x00, 0x00, I2C1_HOOK_NONE)                         \
+    REG(DS3231_REG_TEMP_LSB,    0x00, 0x00, 0x00, I2C1_HOOK_NONE)
+
+const I2C1_REG_t ds3231_reg[DS3231_RAM_SIZE] =
+{
+    DS3231_REGS(I2C1_REG_DESC)
+};
+I2C1_REG_CHECK(ds3231_reg, DS3231_REGS, DS3231_RAM_SIZE);
+
+// Registers 0x00...0x06 hold the time latched on the last START
+uint8_t ds3231_ram[DS3231_RAM_SIZE];
+
+// Live time: the tick builds the next second in the inactive buffer and
+// publishes it with a single index write, so a START never sees half a step
+static uint8_t ds3231_time[2][DS3231_TIME_SIZE];
+static volatile uint8_t ds3231_time_idx = 0;
+
+// Time registers written by the master (bit per register), applied by the tick
+static uint8_t ds3231_time_new[DS3231_TIME_SIZE];
+static volatile uint8_t ds3231_time_mask = 0;
+static volatile bool ds3231_time_set = false;
+
+// Alarms compared once per second on the packed time, see ds3231_alarm_time
+typedef struct
+{
+    uint32_t val;
+    uint32_t mask;          // Fields compared, AxMn = 0
+} DS3231_ALARM_t;
+
+static DS3231_ALARM_t ds3231_alarm[2];
+// A1F, A2F: set by the tick, cleared by the master
+static volatile uint8_t ds3231_alarm_flags = 0;
+static bool ds3231_alarm_dirty = false;
+
+// Temperature in the register format: quarter C in bits 15...6
+static volatile uint16_t ds3231_temp = 0;
+static volatile bool ds3231_temp_busy = false;  // BSY
+static volatile bool ds3231_temp_conv = false;  // CONV, forced by the master
+static uint32_t ds3231_sec = 0;                 // Tick only, model seconds
+#define DS3231_TEMP_PERIOD      64     // Seconds of real time between conversions
+
+// INT/SQW output, open-drain and active low like the device. The square
+// wave comes from TIM3 CH1 on the same pin.
+#define DS3231_INT_PORT         GPIOA
+#define DS3231_INT_PIN          GPIO_Pin_6
+// 32kHz output, open-drain, from TIM4 CH3
+#define DS3231_32K_PORT         GPIOB
+#define DS3231_32K_PIN          GPIO_Pin_8
+
+// INTCN, RS2, RS1 and EN32kHz of the running outputs
+static uint8_t ds3231_out_cfg;
+
+// Backup domain: the RTC counts seconds from the LSE while VBAT is present,
+// the BKP data registers keep the time base and the settings
+// BKP_DR1: backup domain is valid (layout version), the prescaler is
+// write-only, so a build with another time scale starts over
+#define DS3231_LSE_FRQ          32768  // RTC clock
+#define DS3231_BKP_MAGIC        (0x3233 ^ (DS3231_TIME_SCALE - 1))
+#define DS3231_BKP_OFS_L        BKP_DR2 // Time as epoch seconds - RTC counter
+#define DS3231_BKP_OFS_H        BKP_DR3
+#define DS3231_BKP_FLAGS        BKP_DR4 // Day of week offset, 12 hour mode, century
+#define DS3231_BKP_CONFIG       BKP_DR5 // Control, status
+// BKP_DR6...DR9: alarm registers 0x07...0x0D, aging
+
+#define DS3231_BKP_DAY          0x0007 // (epoch day + offset) % 7 + 1 is the day register
+#define DS3231_BKP_12H          0x0008
+#define DS3231_BKP_CENTURY      0x0010 // Century bit at epoch year 0...99
+
+static const uint16_t ds3231_bkp_alarm_dr[4] = {BKP_DR6, BKP_DR7, BKP_DR8, BKP_DR9};
+// Register pairs in BKP_DR6...DR9, low byte first
+static const uint8_t ds3231_bkp_alarm_reg[8] =
+{
+    DS3231_REG_A1_SECONDS, DS3231_REG_A1_MINUTES, DS3231_REG_A1_HOURS, DS3231_REG_A1_DAY_DATE,
+    DS3231_REG_A2_MINUTES, DS3231_REG_A2_HOURS, DS3231_REG_A2_DAY_DATE, DS3231_REG_AGING
+};
+
+// The RTC calibration only slows the clock down, by CAL / 2^20 (0.954 ppm
+// per step). A prescaler of 32766 is 30.5 ppm fast, which DS3231_RTC_CAL
+// takes back, so the aging offset can move the rate to both sides.
+#if (DS3231_TIME_SCALE == 1)
+    #define DS3231_RTC_PRL      32766
+#elif (DS3231_TIME_SCALE > 1) && (DS3231_TIME_SCALE <= DS3231_LSE_FRQ / 2) \
+      && (DS3231_LSE_FRQ % DS3231_TIME_SCALE == 0)
+    // Accelerated: no calibration, the prescaler divides the LSE exactly
+    #define DS3231_RTC_PRL      (DS3231_LSE_FRQ / DS3231_TIME_SCALE - 1)
+#else
+    #error "DS3231_TIME_SCALE: power of 2, 1...16384"
+#endif
+
+// CAL in Q16 from the aging offset, the fraction is dithered by the tick
+static volatile int32_t ds3231_cal = DS3231_RTC_CAL << 16;
+static uint32_t ds3231_cal_acc = 0;             // Tick only
+
+/*******************************************************************/
+// Hours in 24 hour BCD, the alarm may use the other mode than the time
+static uint8_t ds3231_hours_24(uint8_t reg)
+{
+    uint8_t hours;
+
+    if ((reg & DS3231_HOURS_12) == 0)
+    {
+        return reg & 0x3F;
+    }
+
+    // 12 AM is 00, 12 PM is 12
+    hours = CALENDAR_bcd2bin(reg & 0x1F);
+    if (hours == 12) hours = 0;
+    if (reg & DS3231_HOURS_PM) hours += 12;
+
+    return CALENDAR_bin2bcd(hours);
+}
+
+// Seconds since 01.01.00 00:00:00 of the time registers. Every 4th year is
+// a leap year like in the DS3231, the century bit is not part of it.
+static uint32_t ds3231_epoch(const uint8_t *time)
+{
+    uint8_t month = CALENDAR_bcd2bin(time[DS3231_REG_MONTH] & 0x1F);
+
+    // An invalid month counts as January
+    if (month < 1 || month > 12)
+    {
+        month = 1;
+    }
+
+    return CALENDAR_days(CALENDAR_bcd2bin(time[DS3231_REG_YEAR]), month,
+                         CALENDAR_bcd2bin(time[DS3231_REG_DATE] & 0x3F)) * 86400
+         + CALENDAR_bcd2bin(ds3231_hours_24(time[DS3231_REG_HOURS])) * 3600UL
+         + CALENDAR_bcd2bin(time[DS3231_REG_MINUTES] & 0x7F) * 60
+         + CALENDAR_bcd2bin(time[DS3231_REG_SECONDS] & 0x7F);
+}
+
+// Time registers from epoch seconds and the DS3231_BKP_xxx flags
+static void ds3231_from_epoch(uint32_t sec, uint16_t flags, uint8_t *time)
+{
+    uint8_t hms[3];
+    uint32_t days = CALENDAR_split(sec, hms);
+    uint8_t hours = hms[2];
+    uint8_t year, month, date;
+    bool century;
+
+    // The epoch spans 136 years, the century bit toggles at year 100
+    CALENDAR_date(days, &year, &month, &date);
+    century = ((flags & DS3231_BKP_CENTURY) != 0) ^ (year >= 100);
+    if (year >= 100)
+    {
+        year -= 100;
+    }
+
+    time[DS3231_REG_SECONDS] = CALENDAR_bin2bcd(hms[0]);
+    time[DS3231_REG_MINUTES] = CALENDAR_bin2bcd(hms[1]);
+    if (flags & DS3231_BKP_12H)
+    {
+        uint8_t hours12 = (hours >= 12) ? hours - 12 : hours;
+
+        time[DS3231_REG_HOURS] = DS3231_HOURS_12 | ((hours >= 12) ? DS3231_HOURS_PM : 0)
+                               | CALENDAR_bin2bcd((hours12 == 0) ? 12 : hours12);
+    }
+    else
+    {
+        time[DS3231_REG_HOURS] = CALENDAR_bin2bcd(hours);
+    }
+    time[DS3231_REG_DAY] = CALENDAR_weekday(days + (flags & DS3231_BKP_DAY)) + 1;
+    time[DS3231_REG_DATE] = CALENDAR_bin2bcd(date);
+    time[DS3231_REG_MONTH] = CALENDAR_bin2bcd(month) | (century ? DS3231_MONTH_CENTURY : 0);
+    time[DS3231_REG_YEAR] = CALENDAR_bin2bcd(year);
+}
+
+/*******************************************************************/
+// Time base of the current time: it is the RTC counter plus an offset, so
+// the backup domain is only written when the master sets the time
+static void ds3231_bkp_time(const uint8_t *time)
+{
+    uint32_t epoch = ds3231_epoch(time);
+    uint32_t ofs = epoch - RTC_GetCounter();
+    uint8_t hms[3];
+    // Day register 1...7 against the weekday of the epoch day: 0...13
+    uint16_t flags = (time[DS3231_REG_DAY] & 0x07) + 6 - CALENDAR_weekday(CALENDAR_split(epoch, hms));
+
+    if (flags >= 7) flags -= 7;
+
+    if (time[DS3231_REG_HOURS] & DS3231_HOURS_12) flags |= DS3231_BKP_12H;
+    if (time[DS3231_REG_MONTH] & DS3231_MONTH_CENTURY) flags |= DS3231_BKP_CENTURY;
+
+    BKP_WriteBackupRegister(DS3231_BKP_OFS_L, (uint16_t)ofs);
+    BKP_WriteBackupRegister(DS3231_BKP_OFS_H, (uint16_t)(ofs >> 16));
+    BKP_WriteBackupRegister(DS3231_BKP_FLAGS, flags);
+}
+
+// Control and status with the alarm flags, must not be split by the tick
+static void ds3231_bkp_config(void)
+{
+    uint8_t status = (ds3231_ram[DS3231_REG_STATUS] & ~(DS3231_STATUS_A1F | DS3231_STATUS_A2F))
+                   | ds3231_alarm_flags;
+
+    BKP_WriteBackupRegister(DS3231_BKP_CONFIG, ds3231_ram[DS3231_REG_CONTROL] | (status << 8));
+}
+
+// Alarm registers and aging, main loop only
+static void ds3231_bkp_alarm(void)
+{
+    const uint8_t *reg = ds3231_bkp_alarm_reg;
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        BKP_WriteBackupRegister(ds3231_bkp_alarm_dr[i], ds3231_ram[reg[2 * i]] | (ds3231_ram[reg[2 * i + 1]] << 8));
+    }
+}
+
+// Registers of the last run, false if the backup domain was lost
+static bool ds3231_bkp_restore(void)
+{
+    const uint8_t *reg = ds3231_bkp_alarm_reg;
+    uint16_t config;
+    uint32_t ofs;
+
+    if (BKP_ReadBackupRegister(BKP_DR1) != DS3231_BKP_MAGIC || (RCC->BDCR & RCC_BDCR_RTCEN) == 0)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        uint16_t val = BKP_ReadBackupRegister(ds3231_bkp_alarm_dr[i]);
+
+        ds3231_ram[reg[2 * i]] = (uint8_t)val;
+        ds3231_ram[reg[2 * i + 1]] = (uint8_t)(val >> 8);
+    }
+
+    // OSF keeps the state the master has left it in
+    config = BKP_ReadBackupRegister(DS3231_BKP_CONFIG);
+    ds3231_ram[DS3231_REG_CONTROL] = (uint8_t)config & ~DS3231_CONTROL_CONV;
+    ds3231_ram[DS3231_REG_STATUS] = (uint8_t)(config >> 8) & ~DS3231_STATUS_BSY;
+    ds3231_alarm_flags = ds3231_ram[DS3231_REG_STATUS] & (DS3231_STATUS_A1F | DS3231_STATUS_A2F);
+
+    ofs = BKP_ReadBackupRegister(DS3231_BKP_OFS_L) | (BKP_ReadBackupRegister(DS3231_BKP_OFS_H) << 16);
+    ds3231_from_epoch(RTC_GetCounter() + ofs, BKP_ReadBackupRegister(DS3231_BKP_FLAGS), ds3231_ram);
+
+    return true;
+}
+
+// RTC second interrupt from the LSE, true if it kept running over the reset
+static bool ds3231_rtc_init(void)
+{
+    NVIC_InitTypeDef NVIC_InitStructure;
+    bool warm;
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR | RCC_APB1Periph_BKP, ENABLE);
+    PWR_BackupAccessCmd(ENABLE);
+
+    warm = BKP_ReadBackupRegister(BKP_DR1) == DS3231_BKP_MAGIC && (RCC->BDCR & RCC_BDCR_RTCEN);
+
+    /* Lowest priority like the clock update of SysTick before */
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 15;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority        = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd                = ENABLE;
+    NVIC_InitStructure.NVIC_IRQChannel                   = RTC_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+
+    if (warm)
+    {
+        // Fast boot: the counter is readable after the APB resync (< 2 LSE cycles)
+        RTC_WaitForSynchro();
+        RTC_ITConfig(RTC_IT_SEC, ENABLE);
+        RTC_WaitForLastTask();
+        return true;
+    }
+
+    // Backup domain lost: restart it, the LSE startup (up to seconds) must
+    // not delay the I2C slave, the RTC is set up by the LSERDY interrupt
+    RCC_BackupResetCmd(ENABLE);
+    RCC_BackupResetCmd(DISABLE);
+    RCC_LSEConfig(RCC_LSE_ON);
+    RCC_ITConfig(RCC_IT_LSERDY, ENABLE);
+
+    NVIC_InitStructure.NVIC_IRQChannel = RCC_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+
+    return false;
+}
+
+// Seconds, minutes, hours (24), date and day packed into 29 bits
+static uint32_t ds3231_alarm_time(uint8_t sec, uint8_t min, uint8_t hours,
+                                  uint8_t date, uint8_t day)
+{
+    return (uint32_t)(sec & 0x7F)
+         | (uint32_t)(min & 0x7F) << 7
+         | (uint32_t)ds3231_hours_24(hours) << 14
+         | (uint32_t)(date & 0x3F) << 20
+         | (uint32_t)(day & 0x07) << 26;
+}
+
+// Compare value and mask of an alarm from its registers. Alarm 2 has no
+// seconds register, it matches at 00 seconds.
+static void ds3231_alarm_load(DS3231_ALARM_t *alarm, uint8_t sec, const uint8_t *reg)
+{
+    uint8_t day_date = reg[2];
+    bool dy = (day_date & DS3231_ALARM_DY) != 0;
+
+    alarm->val = ds3231_alarm_time(sec, reg[0], reg[1], dy ? 0 : day_date, dy ? day_date : 0);
+    alarm->mask = ds3231_alarm_time((sec & DS3231_ALARM_MASK) ? 0 : 0x7F,
+                                    (reg[0] & DS3231_ALARM_MASK) ? 0 : 0x7F,
+                                    (reg[1] & DS3231_ALARM_MASK) ? 0 : 0x3F,
+                                    ((day_date & DS3231_ALARM_MASK) || dy) ? 0 : 0x3F,
+                                    ((day_date & DS3231_ALARM_MASK) || !dy) ? 0 : 0x07);
+}
+
+// New alarm registers, the tick must not see a half written alarm
+static void ds3231_alarm_update(void)
+{
+    DS3231_ALARM_t alarm[2];
+
+    ds3231_alarm_load(&alarm[0], ds3231_ram[DS3231_REG_A1_SECONDS],
+                      &ds3231_ram[DS3231_REG_A1_MINUTES]);
+    ds3231_alarm_load(&alarm[1], 0x00, &ds3231_ram[DS3231_REG_A2_MINUTES]);
+
+    __disable_irq();
+    memcpy(ds3231_alarm, alarm, sizeof(ds3231_alarm));
+    __enable_irq();
+}
+
+// INT/SQW asserted by an enabled alarm flag in interrupt mode
+static void ds3231_int_update(void)
+{
+    uint8_t control = ds3231_ram[DS3231_REG_CONTROL];
+
+    if ((control & DS3231_CONTROL_INTCN)
+        && (ds3231_alarm_flags & control & (DS3231_CONTROL_A1IE | DS3231_CONTROL_A2IE)))
+    {
+        DS3231_INT_PORT->BRR = DS3231_INT_PIN;
+    }
+    else
+    {
+        DS3231_INT_PORT->BSRR = DS3231_INT_PIN;
+    }
+}
+
+// Output pin driven by a timer channel or by the port bit (released)
+static void ds3231_out_pin(GPIO_TypeDef *port, uint16_t pin, bool timer)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+
+    GPIO_InitStructure.GPIO_Pin = pin;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_2MHz;
+    GPIO_InitStructure.GPIO_Mode = timer ? GPIO_Mode_AF_OD : GPIO_Mode_Out_OD;
+    GPIO_Init(port, &GPIO_InitStructure);
+}
+
+// PWM of DS3231_out_cfg, the timers are clocked with HCLK
+static void ds3231_pwm(TIM_TypeDef *tim, const DS3231_OUT_t *out,
+                       void (*oc_init)(TIM_TypeDef *, TIM_OCInitTypeDef *))
+{
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+    TIM_OCInitTypeDef TIM_OCInitStructure;
+
+    TIM_Cmd(tim, DISABLE);
+
+    TIM_TimeBaseStructure.TIM_Prescaler = out->psc;
+    TIM_TimeBaseStructure.TIM_Period = out->period;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+    TIM_TimeBaseInit(tim, &TIM_TimeBaseStructure);
+
+    TIM_OCStructInit(&TIM_OCInitStructure);
+    TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_PWM1;
+    TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Enable;
+    TIM_OCInitStructure.TIM_OCPolarity = TIM_OCPolarity_High;
+    TIM_OCInitStructure.TIM_Pulse = out->pulse;
+    oc_init(tim, &TIM_OCInitStructure);
+
+    TIM_Cmd(tim, ENABLE);
+}
+
+// SQW and 32kHz outputs after a write of the control or status register,
+// the edges need no CPU. Timers are only touched when a setting changes.
+static void ds3231_out_update(bool init)
+{
+    uint8_t control = ds3231_ram[DS3231_REG_CONTROL];
+    uint8_t status = ds3231_ram[DS3231_REG_STATUS];
+    uint8_t cfg = (control & (DS3231_CONTROL_INTCN | DS3231_CONTROL_RS))
+                | (status & DS3231_STATUS_EN32KHZ);
+    uint8_t changed = init ? 0xFF : cfg ^ ds3231_out_cfg;
+    DS3231_OUT_t out[DS3231_OUT_CNT];
+
+    ds3231_out_cfg = cfg;
+    DS3231_out_cfg(control, status, SystemCoreClock, out);
+
+    if (changed & (DS3231_CONTROL_INTCN | DS3231_CONTROL_RS))
+    {
+        if (out[DS3231_OUT_SQW].timer)
+        {
+            ds3231_pwm(TIM3, &out[DS3231_OUT_SQW], TIM_OC1Init);
+        }
+        else
+        {
+            TIM_Cmd(TIM3, DISABLE);
+        }
+        ds3231_out_pin(DS3231_INT_PORT, DS3231_INT_PIN, out[DS3231_OUT_SQW].timer);
+    }
+
+    if (changed & DS3231_STATUS_EN32KHZ)
+    {
+        if (out[DS3231_OUT_32K].timer)
+        {
+            ds3231_pwm(TIM4, &out[DS3231_OUT_32K], TIM_OC3Init);
+        }
+        else
+        {
+            TIM_Cmd(TIM4, DISABLE);
+        }
+        ds3231_out_pin(DS3231_32K_PORT, DS3231_32K_PIN, out[DS3231_OUT_32K].timer);
+    }
+}
+
+// Aging offset 0x10, see DS3231_cal_q16
+static void ds3231_aging_set(uint8_t aging)
+{
+    ds3231_cal = DS3231_cal_q16(aging);
+}
+
+// New calibration value every 2^20 LSE cycles (32 s), see DS3231_cal_step
+static void ds3231_cal_update(void)
+{
+    if (DS3231_TIME_SCALE != 1)
+    {
+        return;
+    }
+
+    BKP_SetRTCCalibrationValue(DS3231_cal_step(&ds3231_cal_acc, ds3231_cal));
+}
+
+// Temperature conversion every 64 s and on CONV, BSY until DS3231_temp
+static void ds3231_temp_start(bool conv)
+{
+    if (conv)
+    {
+        ds3231_temp_conv = true;
+    }
+    ds3231_temp_busy = true;
+    ADC_temp_start();
+}
+
+/*******************************************************************/
+void DS3231_init(void)
+{
+    for (uint8_t i = 0; i < DS3231_RAM_SIZE; i++)
+    {
+        ds3231_ram[i] = ds3231_reg[i].reset;
+    }
+    // OSF stays set from the reset value if the backup domain was lost
+    if (ds3231_rtc_init())
+    {
+        ds3231_bkp_restore();
+    }
+    ds3231_aging_set(ds3231_ram[DS3231_REG_AGING]);
+    memcpy(ds3231_time[0], ds3231_ram, DS3231_TIME_SIZE);
+    ds3231_alarm_update();
+    // The device converts the temperature at power-on
+    ds3231_temp_start(false);
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3 | RCC_APB1Periph_TIM4, ENABLE);
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA | RCC_APB2Periph_GPIOB, ENABLE);
+
+    /* INT/SQW and 32kHz, released until configured */
+    DS3231_INT_PORT->BSRR = DS3231_INT_PIN;
+    DS3231_32K_PORT->BSRR = DS3231_32K_PIN;
+    ds3231_out_update(true);
+    // An alarm flag kept over the reset still holds INT/SQW low
+    ds3231_int_update();
+}
+
+/*******************************************************************/
+// Called by the timebase only, it is the single writer of the live time.
+// sec: one second has passed, otherwise only a written time is taken.
+void DS3231_tick(bool sec)
+{
+    uint8_t idx = ds3231_time_idx ^ 1;
+    uint8_t *time = ds3231_time[idx];
+    uint32_t now;
+    uint8_t flags = 0;
+    bool set = ds3231_time_set;
+
+    memcpy(time, ds3231_time[ds3231_time_idx], DS3231_TIME_SIZE);
+
+    if (set)
+    {
+        // Written registers replace the counters, the others keep running
+        ds3231_time_set = false;
+        for (uint8_t i = 0; i < DS3231_TIME_SIZE; i++)
+        {
+            if (ds3231_time_mask & (1 << i))
+            {
+                time[i] = ds3231_time_new[i];
+            }
+        }
+    }
+
+    if (sec)
+    {
+        DS3231_time_step(time);
+
+        // Counted in model seconds, the periods are real time: a conversion
+        // (~110 ms) must end before the next one starts
+        ds3231_sec++;
+        if ((ds3231_sec & 0x1F) == 0)
+        {
+            ds3231_cal_update();
+        }
+        if ((ds3231_sec & (DS3231_TEMP_PERIOD * DS3231_TIME_SCALE - 1)) == 0)
+        {
+            ds3231_temp_start(false);
+        }
+
+        // Alarms are checked on the once per second update only
+        now = ds3231_alarm_time(time[DS3231_REG_SECONDS], time[DS3231_REG_MINUTES],
+                                time[DS3231_REG_HOURS], time[DS3231_REG_DATE],
+                                time[DS3231_REG_DAY]);
+        for (uint8_t i = 0; i < 2; i++)
+        {
+            if (((now ^ ds3231_alarm[i].val) & ds3231_alarm[i].mask) == 0)
+            {
+                flags |= DS3231_STATUS_A1F << i;
+            }
+        }
+    }
+
+    ds3231_time_idx = idx;
+
+    if (set)
+    {
+        ds3231_bkp_time(time);
+    }
+
+    if (flags != 0)
+    {
+        ds3231_alarm_flags |= flags;
+        ds3231_int_update();
+        ds3231_bkp_config();
+    }
+}
+
+/*******************************************************************/
+// START with own address: latch the time like the DS3231 secondary buffer
+void DS3231_start(bool read)
+{
+    uint8_t *control = &ds3231_ram[DS3231_REG_CONTROL];
+    uint8_t *status = &ds3231_ram[DS3231_REG_STATUS];
+    uint16_t temp = ds3231_temp;
+
+    (void)read;
+    memcpy(ds3231_ram, ds3231_time[ds3231_time_idx], DS3231_TIME_SIZE);
+
+    // The bank is only written with the I2C event interrupt masked (here
+    // or by the commit), so the flags are merged in here
+    *status = (*status & ~(DS3231_STATUS_A1F | DS3231_STATUS_A2F | DS3231_STATUS_BSY))
+            | ds3231_alarm_flags | (ds3231_temp_busy ? DS3231_STATUS_BSY : 0);
+    *control = (*control & ~DS3231_CONTROL_CONV) | (ds3231_temp_conv ? DS3231_CONTROL_CONV : 0);
+
+    ds3231_ram[DS3231_REG_TEMP_MSB] = (uint8_t)(temp >> 8);
+    ds3231_ram[DS3231_REG_TEMP_LSB] = (uint8_t)temp;
+}
+
+/*******************************************************************/
+// End of a temperature conversion, called by the ADC interrupt with the
+// mean sensor voltage in 1/16 ADC steps
+void DS3231_temp(uint16_t adc)
+{
+    ds3231_temp = DS3231_temp_reg(adc);
+    ds3231_temp_conv = false;
+    ds3231_temp_busy = false;
+}
+
+/*******************************************************************/
+// Register write side effects, called by the main loop
+void DS3231_event(const EVQ_ITEM_t *item)
+{
+    if (item->adr == EVQ_ADR_STOP)
+    {
+        if (ds3231_alarm_dirty)
+        {
+            ds3231_alarm_dirty = false;
+            ds3231_alarm_update();
+            ds3231_bkp_alarm();
+        }
+
+        if (ds3231_time_mask != 0)
+        {
+            // The tick preempts the main loop, so it has taken the time on
+            // return. The RTC keeps its second phase.
+            ds3231_time_set = true;
+            NVIC_SetPendingIRQ(RTC_IRQn);
+            __DSB();
+            __ISB();
+            ds3231_time_mask = 0;
+        }
+        return;
+    }
+
+    switch (ds3231_reg[item->adr].hook)
+    {
+    case DS3231_HOOK_TIME:
+        ds3231_time_new[item->adr] = item->val & ds3231_reg[item->adr].wmask;
+        ds3231_time_mask |= 1 << item->adr;
+        break;
+
+    case DS3231_HOOK_ALARM:
+        ds3231_alarm_dirty = true;
+        break;
+
+    case DS3231_HOOK_AGING:
+        ds3231_aging_set(item->val);
+        ds3231_bkp_alarm();
+        break;
+
+    case DS3231_HOOK_CONTROL:
+    case DS3231_HOOK_STATUS:
+        if (item->adr == DS3231_REG_CONTROL && (item->val & DS3231_CONTROL_CONV))
+        {
+            ds3231_temp_start(true);
+        }
+        ds3231_out_update(false);
+
+        // Writing 0 clears an alarm flag, 1 leaves it unchanged. The tick
+        // sets flags and drives INT/SQW, so the update must not be split.
+        __disable_irq();
+        if (item->adr == DS3231_REG_STATUS)
+        {
+            ds3231_alarm_flags &= item->val | ~(DS3231_STATUS_A1F | DS3231_STATUS_A2F);
+        }
+        ds3231_int_update();
+        ds3231_bkp_config();
+        __enable_irq();
+        break;
+    }
+}
+
+/*******************************************************************/
+void RTC_IRQHandler(void)
+{
+    bool sec = RTC_GetITStatus(RTC_IT_SEC) != RESET;
+
+    if (sec)
+    {
+        RTC_ClearITPendingBit(RTC_IT_SEC);
+    }
+
+    // Also pended by the main loop for a written time
+    DS3231_tick(sec);
+}
+
+// LSE has started after a loss of the backup domain
+void RCC_IRQHandler(void)
+{
+    if (RCC_GetITStatus(RCC_IT_LSERDY) == RESET)
+    {
+        return;
+    }
+
+    RCC_ClearITPendingBit(RCC_IT_LSERDY);
+    RCC_ITConfig(RCC_IT_LSERDY, DISABLE);
+
+    RCC_RTCCLKConfig(RCC_RTCCLKSource_LSE);
+    RCC_RTCCLKCmd(ENABLE);
+    RTC_WaitForSynchro();
+    RTC_WaitForLastTask();
+    RTC_SetPrescaler(DS3231_RTC_PRL); // 1 Hz with DS3231_RTC_CAL
+    RTC_WaitForLastTask();
+    RTC_ITConfig(RTC_IT_SEC, ENABLE);
+    RTC_WaitForLastTask();
+    ds3231_cal_update();
+
+    // Same level as the tick, so the time does not change meanwhile
+    ds3231_bkp_time(ds3231_time[ds3231_time_idx]);
+    ds3231_bkp_config();
+    ds3231_bkp_alarm();
+    BKP_WriteBackupRegister(BKP_DR1, DS3231_BKP_MAGIC);
+}
+
+/*******************************************************************/
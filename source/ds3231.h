@@ -0,0 +1,115 @@
+// DS3231 register model
+// see: https://datasheets.maximintegrated.com/en/ds/DS3231.pdf
+
+#ifndef DS3231_H
+#define DS3231_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "event_queue.h"
+#include "i2c_slave.h"
+
+/*******************************************************************/
+// Time multiplier for rollover and alarm tests: a power of 2 from 1 (real
+// time) to 16384 (free-running, the fastest RTC rate: a prescaler of 0 does
+// not raise the second flag reliably), so the RTC prescaler divides the
+// 32768 Hz LSE exactly. 64 and 4096 come closest to a minute and an hour
+// per second. The RTC runs faster, the tick still steps one second, so the
+// register semantics are unchanged.
+#ifndef DS3231_TIME_SCALE
+    #define DS3231_TIME_SCALE   1
+#endif
+
+#define DS3231_RAM_SIZE         0x13   // Register map in Byte (0x00...0x12)
+
+// Register addresses
+#define DS3231_REG_SECONDS      0x00
+#define DS3231_REG_MINUTES      0x01
+#define DS3231_REG_HOURS        0x02
+#define DS3231_REG_DAY          0x03
+#define DS3231_REG_DATE         0x04
+#define DS3231_REG_MONTH        0x05
+#define DS3231_REG_YEAR         0x06
+#define DS3231_REG_A1_SECONDS   0x07
+#define DS3231_REG_A1_MINUTES   0x08
+#define DS3231_REG_A1_HOURS     0x09
+#define DS3231_REG_A1_DAY_DATE  0x0A
+#define DS3231_REG_A2_MINUTES   0x0B
+#define DS3231_REG_A2_HOURS     0x0C
+#define DS3231_REG_A2_DAY_DATE  0x0D
+#define DS3231_REG_CONTROL      0x0E
+#define DS3231_REG_STATUS       0x0F
+#define DS3231_REG_AGING        0x10
+#define DS3231_REG_TEMP_MSB     0x11
+#define DS3231_REG_TEMP_LSB     0x12
+
+#define DS3231_TIME_SIZE        0x07   // Time registers (0x00...0x06)
+
+// Register bits
+#define DS3231_HOURS_12         0x40   // 12 hour mode
+#define DS3231_HOURS_PM         0x20   // PM in 12 hour mode
+#define DS3231_MONTH_CENTURY    0x80   // Century (year 99 -> 00)
+#define DS3231_ALARM_MASK       0x80   // AxMn: field ignored by the alarm
+#define DS3231_ALARM_DY         0x40   // Alarm on the day instead of the date
+
+#define DS3231_CONTROL_CONV     0x20   // Force a temperature conversion
+#define DS3231_CONTROL_RS       0x18   // SQW rate: 1 Hz, 1.024, 4.096, 8.192 kHz
+#define DS3231_CONTROL_RS_Pos   3
+#define DS3231_CONTROL_INTCN    0x04   // INT/SQW is the alarm interrupt
+#define DS3231_CONTROL_A2IE     0x02
+#define DS3231_CONTROL_A1IE     0x01
+
+#define DS3231_STATUS_OSF       0x80   // Oscillator stop flag
+#define DS3231_STATUS_EN32KHZ   0x08
+#define DS3231_STATUS_BSY       0x04
+#define DS3231_STATUS_A2F       0x02
+#define DS3231_STATUS_A1F       0x01
+
+#define DS3231_32K_FRQ          32768  // 32kHz output in Hz
+
+// RTC calibration (CAL / 2^20) that makes the 32766 prescaler 1 Hz, and
+// the aging offset LSB (0.1 ppm) in CAL steps, Q16: 0.1 * 2^20 / 10^6 * 2^16
+#define DS3231_RTC_CAL          32
+#define DS3231_AGING_CAL        6872
+
+// Outputs driven by a timer
+typedef enum
+{
+    DS3231_OUT_SQW,         // INT/SQW, TIM3 CH1
+    DS3231_OUT_32K,         // 32kHz, TIM4 CH3
+    DS3231_OUT_CNT,
+} DS3231_OUT_ID_t;
+
+typedef struct
+{
+    bool     timer;         // Pin driven by the timer, else by the port bit
+    uint16_t psc;           // TIM_Prescaler
+    uint16_t period;        // TIM_Period
+    uint16_t pulse;         // TIM_Pulse, 50 % duty cycle
+} DS3231_OUT_t;
+
+// STM32F103 temperature sensor, typical values of the datasheet
+#define DS3231_TEMP_V25         1430   // mV at 25 C
+#define DS3231_TEMP_SLOPE       4300   // uV per C
+
+/*******************************************************************/
+
+extern uint8_t ds3231_ram[DS3231_RAM_SIZE];
+extern const I2C1_REG_t ds3231_reg[DS3231_RAM_SIZE];
+
+void DS3231_init(void);
+void DS3231_tick(bool sec);
+void DS3231_temp(uint16_t adc);
+uint16_t DS3231_temp_reg(uint16_t adc);
+void DS3231_time_step(uint8_t *time);
+int32_t DS3231_cal_q16(uint8_t aging);
+uint8_t DS3231_cal_step(uint32_t *acc, int32_t cal);
+void DS3231_out_cfg(uint8_t control, uint8_t status, uint32_t clock, DS3231_OUT_t out[DS3231_OUT_CNT]);
+
+void DS3231_start(bool read);
+void DS3231_event(const EVQ_ITEM_t *item);
+
+#endif // DS3231_H
+
+/*******************************************************************/
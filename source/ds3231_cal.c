@@ -0,0 +1,25 @@
+#include "ds3231.h"
+
+/*******************************************************************/
+// CAL in Q16 of the aging offset 0x10: positive values slow the clock
+// down like the DS3231 (~0.1 ppm per LSB at 25 C)
+int32_t DS3231_cal_q16(uint8_t aging)
+{
+    return (DS3231_RTC_CAL << 16) + (int8_t)aging * DS3231_AGING_CAL;
+}
+
+// Calibration value for the next 2^20 LSE cycles (32 s), the fractional
+// part of CAL is carried over in acc, so the mean rate has 0.1 ppm
+// resolution; no hardware access so it also builds on the host
+uint8_t DS3231_cal_step(uint32_t *acc, int32_t cal)
+{
+    uint8_t step;
+
+    *acc += cal;
+    step = *acc >> 16;
+    *acc &= 0xFFFF;
+
+    return step;
+}
+
+/*******************************************************************/
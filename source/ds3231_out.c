@@ -0,0 +1,43 @@
+#include "ds3231.h"
+
+/*******************************************************************/
+// SQW frequency of the RS2/RS1 settings in Hz
+static const uint16_t ds3231_sqw_frq[4] = {1, 1024, 4096, 8192};
+
+/*******************************************************************/
+// PWM with 50 % duty cycle from the timer clock, the prescaler is the
+// smallest one that lets the period fit into 16 bit
+static void ds3231_out_pwm(DS3231_OUT_t *out, uint32_t clock, uint32_t frq)
+{
+    uint32_t ticks = clock / frq;
+    uint32_t psc = ticks / 0x10000 + 1;
+
+    out->timer = true;
+    out->psc = psc - 1;
+    out->period = ticks / psc - 1;
+    out->pulse = (ticks / psc) / 2;
+}
+
+// Timer settings of the INT/SQW and 32kHz outputs from the control and
+// status registers, no hardware access so it also builds on the host
+void DS3231_out_cfg(uint8_t control, uint8_t status, uint32_t clock, DS3231_OUT_t out[DS3231_OUT_CNT])
+{
+    DS3231_OUT_t off = {false, 0, 0, 0};
+
+    out[DS3231_OUT_SQW] = off;
+    out[DS3231_OUT_32K] = off;
+
+    // INTCN: the port bit is the alarm interrupt
+    if ((control & DS3231_CONTROL_INTCN) == 0)
+    {
+        ds3231_out_pwm(&out[DS3231_OUT_SQW], clock,
+                       ds3231_sqw_frq[(control & DS3231_CONTROL_RS) >> DS3231_CONTROL_RS_Pos]);
+    }
+
+    if (status & DS3231_STATUS_EN32KHZ)
+    {
+        ds3231_out_pwm(&out[DS3231_OUT_32K], clock, DS3231_32K_FRQ);
+    }
+}
+
+/*******************************************************************/
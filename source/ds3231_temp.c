@@ -0,0 +1,24 @@
+#include "ds3231.h"
+
+/*******************************************************************/
+// Sensor voltage at 25 C in 1/16 ADC steps (3.3 V) and quarter C per
+// 1/16 ADC step in Q16
+#define DS3231_TEMP_V25_ADC     ((DS3231_TEMP_V25 * 65536 + 1650) / 3300)
+#define DS3231_TEMP_GAIN        ((4 * 3300000 + DS3231_TEMP_SLOPE / 2) / DS3231_TEMP_SLOPE)
+
+/*******************************************************************/
+// Temperature registers 0x11/0x12 (MSB first) of the mean sensor voltage in
+// 1/16 ADC steps, no hardware access so it also builds on the host
+uint16_t DS3231_temp_reg(uint16_t adc)
+{
+    int32_t quarter = 25 * 4
+                    + ((((int32_t)DS3231_TEMP_V25_ADC - adc) * DS3231_TEMP_GAIN + 0x8000) >> 16);
+
+    // 10 bit two's complement: -128.00 ... +127.75 C
+    if (quarter > 511) quarter = 511;
+    if (quarter < -512) quarter = -512;
+
+    return (uint16_t)((uint16_t)quarter << 6);
+}
+
+/*******************************************************************/
@@ -0,0 +1,87 @@
+#include "ds3231.h"
+#include "calendar.h"
+
+/*******************************************************************/
+// Last date of the month in BCD, index is the binary month
+static const uint8_t ds3231_month_len[13] =
+{
+    0x31, 0x31, 0x28, 0x31, 0x30, 0x31, 0x30, 0x31, 0x31, 0x30, 0x31, 0x30, 0x31,
+};
+
+/*******************************************************************/
+// Increment of the BCD field selected by mask, returns true on overflow
+static bool ds3231_bcd_inc(uint8_t *reg, uint8_t mask, uint8_t min, uint8_t max)
+{
+    uint8_t val = *reg & mask;
+
+    if (val >= max)
+    {
+        *reg = (*reg & ~mask) | min;
+        return true;
+    }
+
+    val = ((val & 0x0F) == 0x09) ? val + 0x07 : val + 1;
+    *reg = (*reg & ~mask) | val;
+
+    return false;
+}
+
+// Leap year check of the BCD year (the century is ignored as in DS3231)
+static bool ds3231_is_leap(uint8_t year)
+{
+    return ((((year >> 4) << 1) + (year & 0x0F)) & 0x03) == 0;
+}
+
+static bool ds3231_hours_inc(uint8_t *reg)
+{
+    uint8_t hours;
+
+    if ((*reg & DS3231_HOURS_12) == 0)
+    {
+        return ds3231_bcd_inc(reg, 0x3F, 0x00, 0x23);
+    }
+
+    // 12 hour mode: 11 -> 12 toggles AM/PM, 12 -> 1 without carry
+    hours = *reg & 0x1F;
+    if (hours == 0x11)
+    {
+        *reg = (*reg & ~0x1F) | 0x12;
+        *reg ^= DS3231_HOURS_PM;
+        // 11 PM -> 12 AM is the next day
+        return (*reg & DS3231_HOURS_PM) == 0;
+    }
+
+    ds3231_bcd_inc(reg, 0x1F, 0x01, 0x12);
+
+    return false;
+}
+
+/*******************************************************************/
+// One second step of the time registers 0x00...0x06: only the fields
+// reached by the carry are touched, no hardware access
+void DS3231_time_step(uint8_t *ram)
+{
+    uint8_t month_len;
+    uint8_t month;
+
+    if (!ds3231_bcd_inc(&ram[DS3231_REG_SECONDS], 0x7F, 0x00, 0x59)) return;
+    if (!ds3231_bcd_inc(&ram[DS3231_REG_MINUTES], 0x7F, 0x00, 0x59)) return;
+    if (!ds3231_hours_inc(&ram[DS3231_REG_HOURS])) return;
+
+    ds3231_bcd_inc(&ram[DS3231_REG_DAY], 0x07, 0x01, 0x07);
+
+    month = CALENDAR_bcd2bin(ram[DS3231_REG_MONTH] & 0x1F);
+    month_len = ds3231_month_len[(month < 13) ? month : 0];
+    if (month == 2 && ds3231_is_leap(ram[DS3231_REG_YEAR]))
+    {
+        month_len = 0x29;
+    }
+
+    if (!ds3231_bcd_inc(&ram[DS3231_REG_DATE], 0x3F, 0x01, month_len)) return;
+    if (!ds3231_bcd_inc(&ram[DS3231_REG_MONTH], 0x1F, 0x01, 0x12)) return;
+    if (!ds3231_bcd_inc(&ram[DS3231_REG_YEAR], 0xFF, 0x00, 0x99)) return;
+
+    ram[DS3231_REG_MONTH] ^= DS3231_MONTH_CENTURY;
+}
+
+/*******************************************************************/
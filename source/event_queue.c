@@ -0,0 +1,82 @@
+#include "event_queue.h"
+
+#include "RTE_Components.h"
+#include CMSIS_device_header
+
+/*******************************************************************/
+volatile uint32_t evq_overflow = 0;
+volatile uint8_t  evq_level_max = 0;
+
+static EVQ_ITEM_t evq_buf[EVQ_SIZE];
+// Free-running indices: head is written by the producer only, tail by
+// the consumer only
+static volatile uint8_t evq_head = 0;
+static volatile uint8_t evq_tail = 0;
+
+/*******************************************************************/
+void EVQ_init(void)
+{
+    // Timestamps come from the DWT cycle counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*******************************************************************/
+// Producer side, called from the I2C interrupts. The last item is kept
+// for the end of a transaction, so queued writes are always terminated.
+bool EVQ_put(uint8_t dev, uint8_t adr, uint8_t val)
+{
+    uint8_t head = evq_head;
+    uint8_t level = (uint8_t)(head - evq_tail);
+    EVQ_ITEM_t *item;
+
+    if (level >= ((adr >= EVQ_ADR_ABORT) ? EVQ_SIZE : EVQ_SIZE - 1))
+    {
+        evq_overflow++;
+        return false;
+    }
+
+    item = &evq_buf[head & (EVQ_SIZE - 1)];
+    item->time = DWT->CYCCNT;
+    item->dev = dev;
+    item->adr = adr;
+    item->val = val;
+
+    // The item must be complete before the consumer can see it
+    __DMB();
+    evq_head = head + 1;
+
+    if (level >= evq_level_max)
+    {
+        evq_level_max = level + 1;
+    }
+
+    return true;
+}
+
+/*******************************************************************/
+// Consumer side, called from the main loop
+bool EVQ_get(EVQ_ITEM_t *item)
+{
+    uint8_t tail = evq_tail;
+
+    if (tail == evq_head)
+    {
+        return false;
+    }
+
+    // The item must not be read before the producer has published it
+    __DMB();
+    *item = evq_buf[tail & (EVQ_SIZE - 1)];
+    __DMB();
+    evq_tail = tail + 1;
+
+    return true;
+}
+
+bool EVQ_empty(void)
+{
+    return evq_tail == evq_head;
+}
+
+/*******************************************************************/
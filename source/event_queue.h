@@ -0,0 +1,36 @@
+// Lock-free queue of register write events from the I2C interrupts to the
+// superloop. Single producer (I2C1 event/error interrupts, same priority)
+// and single consumer (main loop), so no interrupt locking is needed.
+
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************/
+#define EVQ_SIZE                64     // Items, power of 2
+#define EVQ_ADR_STOP            0xFF   // End of a write transaction, commit
+#define EVQ_ADR_ABORT           0xFE   // Write transaction discarded
+
+typedef struct
+{
+    uint32_t time;          // DWT cycle counter at the write
+    uint8_t  dev;           // I2C1_DEV_t
+    uint8_t  adr;           // Register address or EVQ_ADR_STOP
+    uint8_t  val;           // Written value
+} EVQ_ITEM_t;
+
+/*******************************************************************/
+
+extern volatile uint32_t evq_overflow;  // Items dropped on a full queue
+extern volatile uint8_t  evq_level_max; // Highest fill level seen
+
+void EVQ_init(void);
+bool EVQ_put(uint8_t dev, uint8_t adr, uint8_t val);
+bool EVQ_get(EVQ_ITEM_t *item);
+bool EVQ_empty(void);
+
+#endif // EVENT_QUEUE_H
+
+/*******************************************************************/
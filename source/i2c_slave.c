@@ -1,25 +1,250 @@
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "i2c_slave.h"
+#include "ds3231.h"
+#include "ads1115.h"
+#include "prof.h"
+#include "trace.h"
 
 #include "RTE_Components.h"
 #include CMSIS_device_header
 
 /*******************************************************************/
-I2C1_MODE_t i2c1_mode = I2C1_MODE_WAITING;
+volatile I2C1_MODE_t i2c1_mode = I2C1_MODE_WAITING;
+uint32_t i2c1_ev_unknown_cnt = 0;
 
-uint8_t i2c1_ram_adr = 0;
-uint8_t i2c1_ram[I2C1_RAM_SIZE];
+I2C1_BANK_t i2c1_bank[I2C1_DEV_CNT] =
+{
+    // Byte registers, the pointer is the byte address
+    [I2C1_DEV_DS3231] =
+    {
+        .ram = ds3231_ram,   .reg = ds3231_reg,      .size = DS3231_RAM_SIZE,
+        .ptr_mask = 0xFF,    .ptr_shift = 0,         .inc_mask = 0xFF,
+        .start = DS3231_start, .event = DS3231_event,
+    },
+    // 16 bit registers MSB first, a burst stays in the selected register
+    [I2C1_DEV_ADS1115] =
+    {
+        .ram = ads1115_ram,  .reg = ads1115_reg,     .size = ADS1115_RAM_SIZE,
+        .ptr_mask = ADS1115_PTR_MASK, .ptr_shift = 1, .inc_mask = 0x01,
+        .start = ADS1115_start, .event = ADS1115_event,
+    },
+};
+
+// Bank of the device addressed by the current transaction
+static I2C1_BANK_t *i2c1_bank_cur = &i2c1_bank[I2C1_DEV_DS3231];
+
+// Data bytes of the current write transaction are in the event queue, and
+// whether bytes were dropped on a full queue. Interrupts only.
+static bool i2c1_wr_staged = false;
+static bool i2c1_wr_lost = false;
+
+// Write transaction collected by the main loop until it is committed
+#define I2C1_SHADOW_SIZE    32     // Bytes, one bit each in the mask
+
+static uint8_t  i2c1_shadow[I2C1_SHADOW_SIZE];
+static uint32_t i2c1_shadow_mask = 0;
+static uint8_t  i2c1_shadow_dev;
+
+// Address of the byte last loaded into DR for the master, per byte path
+static uint8_t i2c1_tx_adr;
+
+// STOP of a transaction waiting for the bus to be idle, see i2c1_commit
+static EVQ_ITEM_t i2c1_commit_stop;
+static bool i2c1_commit_wait = false;
+
+typedef char i2c1_shadow_fits[(DS3231_RAM_SIZE <= I2C1_SHADOW_SIZE
+                               && ADS1115_RAM_SIZE <= I2C1_SHADOW_SIZE) ? 1 : -1];
+
+/*******************************************************************/
+static uint8_t get_i2c1_ram(I2C1_BANK_t *bank)
+{
+#if (PROF_ENABLE != 0)
+    if (bank == &i2c1_bank[I2C1_DEV_DS3231] && bank->adr >= PROF_REG_BASE)
+    {
+        return PROF_read(bank->adr - PROF_REG_BASE);
+    }
+#endif
+    // Reading outside of the register map returns an idle bus level
+    return (bank->adr < bank->size) ? bank->ram[bank->adr] : 0xFF;
+}
+
+// Stages a written byte, the bank is only changed by the commit at STOP
+static void put_i2c1_wr(I2C1_BANK_t *bank, uint8_t adr, uint8_t val)
+{
+    if (EVQ_put(bank - i2c1_bank, adr, val))
+    {
+        i2c1_wr_staged = true;
+    }
+    else
+    {
+        i2c1_wr_lost = true;
+    }
+}
+
+// End of the write transaction: commit or discard the staged bytes
+static void end_i2c1_wr(bool commit)
+{
+    if (i2c1_wr_lost)
+    {
+        TRACE_error(TRACE_ERR_LOST);
+    }
+
+    if (i2c1_wr_staged)
+    {
+        EVQ_put(i2c1_bank_cur - i2c1_bank,
+                (commit && !i2c1_wr_lost) ? EVQ_ADR_STOP : EVQ_ADR_ABORT, 0);
+    }
+
+    i2c1_wr_staged = false;
+    i2c1_wr_lost = false;
+}
+
+static void set_i2c1_ram(I2C1_BANK_t *bank, uint8_t val)
+{
+#if (PROF_ENABLE != 0)
+    if (bank == &i2c1_bank[I2C1_DEV_DS3231] && bank->adr >= PROF_REG_BASE)
+    {
+        PROF_clear();
+        return;
+    }
+#endif
+    // Writing outside of the register map is ignored
+    if (bank->adr < bank->size)
+    {
+        put_i2c1_wr(bank, bank->adr, val);
+    }
+}
+
+// Byte address n bytes further, bits outside of inc_mask are kept. Like
+// the devices the pointer wraps from the end of the map to 0x00 (DS3231
+// 0x12 -> 0x00), bursts never run further than the end of the map.
+static uint8_t add_i2c1_adr(const I2C1_BANK_t *bank, uint8_t n)
+{
+    uint8_t adr = (bank->adr & ~bank->inc_mask) | ((bank->adr + n) & bank->inc_mask);
+
+    return (adr == bank->size) ? 0 : adr;
+}
 
 /*******************************************************************/
-static uint8_t get_i2c1_ram(uint8_t adr)
+#if (I2C1_DMA != 0)
+
+// Bytes sent by DMA from the current register address
+static void trace_i2c1_tx(uint8_t cnt)
+{
+#if (TRACE_ENABLE != 0)
+    for (uint8_t i = 0; i < cnt; i++)
+    {
+        TRACE_byte(i2c1_bank_cur->ram[i2c1_bank_cur->adr + i]);
+    }
+#else
+    (void)cnt;
+#endif
+}
+
+// Channel moving the data bytes of the current transaction, NULL if none
+static DMA_Channel_TypeDef *i2c1_dma_ch = NULL;
+static uint8_t i2c1_dma_len;
+// Received data bytes, staged at the end of the DMA transfer
+static uint8_t i2c1_dma_rx[I2C1_SHADOW_SIZE];
+
+// Hand the rest of the register bank over to DMA, false if it is exhausted
+static bool i2c1_dma_start(DMA_Channel_TypeDef *ch)
+{
+    uint16_t end = (i2c1_bank_cur->adr | i2c1_bank_cur->inc_mask) + 1;
+
+    if (i2c1_bank_cur->adr >= i2c1_bank_cur->size)
+    {
+        return false;
+    }
+
+    // DMA runs up to the end of the bank or of the burst region
+    if (end > i2c1_bank_cur->size)
+    {
+        end = i2c1_bank_cur->size;
+    }
+
+    i2c1_dma_ch = ch;
+    i2c1_dma_len = end - i2c1_bank_cur->adr;
+
+    ch->CMAR = (ch == DMA1_Channel7) ? (uint32_t)i2c1_dma_rx
+                                     : (uint32_t)&i2c1_bank_cur->ram[i2c1_bank_cur->adr];
+    DMA_SetCurrDataCounter(ch, i2c1_dma_len);
+    DMA_Cmd(ch, ENABLE);
+
+    // The CPU only wakes up on STOP, AF or the end of the bank
+    I2C_ITConfig(I2C1, I2C_IT_BUF, DISABLE);
+    I2C_DMACmd(I2C1, ENABLE);
+
+    return true;
+}
+
+// Back to one interrupt per byte, returns the number of bytes moved by DMA
+static uint8_t i2c1_dma_stop(void)
+{
+    uint8_t cnt;
+
+    I2C_DMACmd(I2C1, DISABLE);
+    DMA_Cmd(i2c1_dma_ch, DISABLE);
+    I2C_ITConfig(I2C1, I2C_IT_BUF, ENABLE);
+
+    cnt = i2c1_dma_len - DMA_GetCurrDataCounter(i2c1_dma_ch);
+    i2c1_dma_ch = NULL;
+
+    return cnt;
+}
+
+static void i2c1_dma_end(void)
 {
-    return i2c1_ram[adr];
+    DMA_Channel_TypeDef *ch = i2c1_dma_ch;
+    uint8_t cnt;
+
+    if (ch == NULL)
+    {
+        return;
+    }
+
+    cnt = i2c1_dma_stop();
+
+    if (ch == DMA1_Channel6)
+    {
+        // The byte left in DR has not been clocked out to the master
+        if ((I2C1->SR1 & I2C_SR1_TXE) == 0)
+        {
+            if (cnt == 0)
+            {
+                // Still the last byte before the restart at the wrap
+                i2c1_bank_cur->adr = i2c1_tx_adr;
+                TRACE_unsent();
+                return;
+            }
+            cnt--;
+        }
+        trace_i2c1_tx(cnt);
+    }
+    else
+    {
+        for (uint8_t i = 0; i < cnt; i++)
+        {
+            put_i2c1_wr(i2c1_bank_cur, i2c1_bank_cur->adr + i, i2c1_dma_rx[i]);
+            TRACE_byte(i2c1_dma_rx[i]);
+        }
+    }
+
+    i2c1_bank_cur->adr = add_i2c1_adr(i2c1_bank_cur, cnt);
 }
 
-static void set_i2c1_ram(uint8_t adr, uint8_t val)
+#endif // I2C1_DMA
+
+static void select_i2c1_bank(I2C1_DEV_t dev, bool read)
 {
-    i2c1_ram[adr] = val;
+    i2c1_bank_cur = &i2c1_bank[dev];
+
+    if (i2c1_bank_cur->start != NULL)
+    {
+        i2c1_bank_cur->start(read);
+    }
 }
 
 /*******************************************************************/
@@ -28,6 +253,9 @@ void I2C1_Slave_init(void)
     GPIO_InitTypeDef  GPIO_InitStructure;
     NVIC_InitTypeDef NVIC_InitStructure;
     I2C_InitTypeDef  I2C_InitStructure;
+#if (I2C1_DMA != 0)
+    DMA_InitTypeDef  DMA_InitStructure;
+#endif
 
     RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C1, ENABLE);
     RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
@@ -71,104 +299,386 @@ void I2C1_Slave_init(void)
     I2C_ITConfig(I2C1, I2C_IT_EVT, ENABLE); //Part of the STM32 I2C driver
     I2C_ITConfig(I2C1, I2C_IT_BUF, ENABLE);
     I2C_ITConfig(I2C1, I2C_IT_ERR, ENABLE); //Part of the STM32 I2C driver
+
+    EVQ_init();
+
+#if (I2C1_DMA != 0)
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&I2C1->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = 0; // set on each transfer
+    DMA_InitStructure.DMA_BufferSize = 1;     // set on each transfer
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+
+    /* I2C1_TX */
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_Init(DMA1_Channel6, &DMA_InitStructure);
+    DMA_ITConfig(DMA1_Channel6, DMA_IT_TC, ENABLE);
+
+    /* I2C1_RX */
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_Init(DMA1_Channel7, &DMA_InitStructure);
+    DMA_ITConfig(DMA1_Channel7, DMA_IT_TC, ENABLE);
+
+    /* End of the register bank, same priority as the I2C events */
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel6_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel7_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+#endif
 }
-/*******************************************************************/
 
 /*******************************************************************/
-static void I2C1_ClearFlag(void)
+// Applies a complete write transaction to the bank, then runs its hooks.
+// False while another transaction is in progress: a read burst (per byte
+// or by DMA) must not see old and new registers mixed, so the commit
+// waits for its end (STOP, NACK or bus error).
+static bool i2c1_commit(const EVQ_ITEM_t *stop)
+{
+    I2C1_BANK_t *bank = &i2c1_bank[stop->dev];
+    EVQ_ITEM_t item = *stop;
+
+    // No transaction can start meanwhile, a START in between is served
+    // after the commit and sees the registers all new
+    NVIC_DisableIRQ(I2C1_EV_IRQn);
+    if (i2c1_mode != I2C1_MODE_WAITING)
+    {
+        NVIC_EnableIRQ(I2C1_EV_IRQn);
+        return false;
+    }
+    for (uint8_t adr = 0; adr < bank->size; adr++)
+    {
+        if (i2c1_shadow_mask & (1UL << adr))
+        {
+            const I2C1_REG_t *reg = &bank->reg[adr];
+            uint8_t val = i2c1_shadow[adr];
+
+            // Read-only bits keep their value, w0c bits can only be cleared
+            bank->ram[adr] = (bank->ram[adr] & ~reg->wmask & (val | ~reg->w0c)) | (val & reg->wmask);
+        }
+    }
+    NVIC_EnableIRQ(I2C1_EV_IRQn);
+
+    // Hooks get the value as written by the master (e.g. for start bits
+    // that are not stored)
+    for (uint8_t adr = 0; adr < bank->size; adr++)
+    {
+        if ((i2c1_shadow_mask & (1UL << adr)) && bank->reg[adr].hook != I2C1_HOOK_NONE)
+        {
+            item.adr = adr;
+            item.val = i2c1_shadow[adr];
+            bank->event(&item);
+        }
+    }
+
+    bank->event(stop);
+
+    return true;
+}
+
+// Runs the write transactions posted by the interrupts
+void I2C1_Slave_poll(void)
 {
-    // ADDR-Flag clear
-    while ((I2C1->SR1 & I2C_SR1_ADDR) == I2C_SR1_ADDR)
+    EVQ_ITEM_t item;
+
+    if (i2c1_commit_wait)
     {
-        I2C1->SR1;
-        I2C1->SR2;
+        if (!i2c1_commit(&i2c1_commit_stop))
+        {
+            return;
+        }
+        i2c1_commit_wait = false;
+        i2c1_shadow_mask = 0;
     }
 
-    // STOPF Flag clear
-    while ((I2C1->SR1 & I2C_SR1_STOPF) == I2C_SR1_STOPF)
+    while (EVQ_get(&item))
     {
-        I2C1->SR1;
-        I2C1->CR1 |= 0x1;
+        if (item.adr == EVQ_ADR_STOP)
+        {
+            if (!i2c1_commit(&item))
+            {
+                // The following transactions stay queued behind it
+                i2c1_commit_stop = item;
+                i2c1_commit_wait = true;
+                return;
+            }
+        }
+        else if (item.adr != EVQ_ADR_ABORT)
+        {
+            if (i2c1_shadow_mask != 0 && item.dev != i2c1_shadow_dev)
+            {
+                // Only one transaction is open at a time
+                i2c1_shadow_mask = 0;
+            }
+            i2c1_shadow_dev = item.dev;
+            i2c1_shadow[item.adr] = item.val;
+            i2c1_shadow_mask |= 1UL << item.adr;
+            continue;
+        }
+
+        i2c1_shadow_mask = 0;
     }
 }
+
+// Nothing left for the main loop: the commit of a transaction that waits
+// for the bus is retried without sleeping
+bool I2C1_Slave_idle(void)
+{
+    return EVQ_empty() && !i2c1_commit_wait;
+}
 /*******************************************************************/
 
 /*******************************************************************/
-void I2C1_EV_IRQHandler(void)
+// Event handlers, SR1 has already been read by I2C1_EV_IRQHandler
+static void i2c1_ev_addr(void)
 {
-    uint32_t event;
+    // Reading SR2 after SR1 clears ADDR
+    uint16_t sr2 = I2C1->SR2;
+    bool read = (sr2 & I2C_SR2_TRA) != 0;
     uint8_t wert;
 
-    // Reading last event
-    event = I2C_GetLastEvent(I2C1);
+#if (I2C1_DMA != 0)
+    // A repeated START ends the transfer of the last address: the received
+    // bytes are staged before the write ends, the channel is released
+    i2c1_dma_end();
+#endif
+    // A repeated START ends a write like a STOP
+    end_i2c1_wr(true);
+    TRACE_end();
+    PROF_boot();
+
+    // DUALF tells which of the own addresses has matched
+    select_i2c1_bank((sr2 & I2C_SR2_DUALF) ? I2C1_DEV_ADS1115 : I2C1_DEV_DS3231, read);
+#if (PROF_ENABLE != 0)
+    // Like the time registers the diagnostic window is read from a copy,
+    // also for reads starting below it which run into it
+    if (read && i2c1_bank_cur == &i2c1_bank[I2C1_DEV_DS3231] && i2c1_bank_cur->adr >= DS3231_RAM_SIZE)
+    {
+        PROF_snapshot();
+    }
+#endif
+    TRACE_start(i2c1_bank_cur - i2c1_bank, read, i2c1_bank_cur->adr);
 
-    if (false
-        || event == I2C_EVENT_SLAVE_RECEIVER_ADDRESS_MATCHED
-        || event == I2C_EVENT_SLAVE_RECEIVER_SECONDADDRESS_MATCHED
-       )
+    if (!read)
     {
         // Master has sent the slave address to send data to the slave
         i2c1_mode = I2C1_MODE_SLAVE_ADR_WR;
+        return;
     }
-    else if (event == I2C_EVENT_SLAVE_BYTE_RECEIVED)
+
+    // Master has sent the slave address to read data from the slave
+    i2c1_mode = I2C1_MODE_SLAVE_ADR_RD;
+#if (I2C1_DMA != 0)
+    if (i2c1_dma_start(DMA1_Channel6))
     {
-        // Master has sent a byte to the slave
-        wert = I2C_ReceiveData(I2C1);
-        // Check address
-        if (i2c1_mode == I2C1_MODE_SLAVE_ADR_WR)
-        {
-            i2c1_mode = I2C1_MODE_ADR_BYTE;
-            // Set current ram address
-            i2c1_ram_adr = wert;
-        }
-        else
-        {
-            i2c1_mode = I2C1_MODE_DATA_BYTE_WR;
-            // Store data in RAM
-            set_i2c1_ram(i2c1_ram_adr, wert);
-            // Next ram adress
-            i2c1_ram_adr++;
-        }
-    }
-    else if (false
-             || event == I2C_EVENT_SLAVE_TRANSMITTER_ADDRESS_MATCHED
-             || event == I2C_EVENT_SLAVE_TRANSMITTER_SECONDADDRESS_MATCHED
-            )
-    {
-        // Master has sent the slave address to read data from the slave
-        i2c1_mode = I2C1_MODE_SLAVE_ADR_RD;
-        // Read data from RAM
-        wert = get_i2c1_ram(i2c1_ram_adr);
-        // Send data to the master
-        I2C_SendData(I2C1, wert);
-        // Next ram adress
-        i2c1_ram_adr++;
+        return;
     }
-    else if (event == I2C_EVENT_SLAVE_BYTE_TRANSMITTED)
+#endif
+    // Read data from RAM
+    wert = get_i2c1_ram(i2c1_bank_cur);
+    // Send data to the master
+    I2C_SendData(I2C1, wert);
+    TRACE_byte(wert);
+    // Next ram adress
+    i2c1_tx_adr = i2c1_bank_cur->adr;
+    i2c1_bank_cur->adr = add_i2c1_adr(i2c1_bank_cur, 1);
+}
+
+static void i2c1_ev_rx(void)
+{
+    // Master has sent a byte to the slave
+    uint8_t wert = I2C_ReceiveData(I2C1);
+
+    // Check address
+    if (i2c1_mode == I2C1_MODE_SLAVE_ADR_WR)
     {
-        // Master wants to read another byte of data from the slave
-        i2c1_mode = I2C1_MODE_DATA_BYTE_RD;
-        // Read data from RAM
-        wert = get_i2c1_ram(i2c1_ram_adr);
-        // Send data to the master
-        I2C_SendData(I2C1, wert);
-        // Next ram adress
-        i2c1_ram_adr++;
+        i2c1_mode = I2C1_MODE_ADR_BYTE;
+        // Set current ram address from the register pointer
+        i2c1_bank_cur->adr = (wert & i2c1_bank_cur->ptr_mask) << i2c1_bank_cur->ptr_shift;
+        TRACE_ptr(i2c1_bank_cur->adr);
+#if (I2C1_DMA != 0)
+        // Data bytes go straight to the register bank
+        i2c1_dma_start(DMA1_Channel7);
+#endif
     }
-    else if (event | I2C_EVENT_SLAVE_STOP_DETECTED)
+    else
     {
-        // Master has STOP sent
-        I2C1_ClearFlag();
-        i2c1_mode = I2C1_MODE_WAITING;
+        i2c1_mode = I2C1_MODE_DATA_BYTE_WR;
+        // Store data in RAM
+        set_i2c1_ram(i2c1_bank_cur, wert);
+        TRACE_byte(wert);
+        // Next ram adress
+        i2c1_bank_cur->adr = add_i2c1_adr(i2c1_bank_cur, 1);
     }
 }
 
+static void i2c1_ev_tx(void)
+{
+    uint8_t wert;
+
+    // Master wants to read another byte of data from the slave
+    i2c1_mode = I2C1_MODE_DATA_BYTE_RD;
+    // Read data from RAM
+    wert = get_i2c1_ram(i2c1_bank_cur);
+    // Send data to the master
+    I2C_SendData(I2C1, wert);
+    TRACE_byte(wert);
+    // Next ram adress
+    i2c1_tx_adr = i2c1_bank_cur->adr;
+    i2c1_bank_cur->adr = add_i2c1_adr(i2c1_bank_cur, 1);
+}
+
+static void i2c1_ev_stop(void)
+{
+    // Master has STOP sent, writing CR1 after SR1 clears STOPF
+    I2C1->CR1 |= I2C_CR1_PE;
+    i2c1_mode = I2C1_MODE_WAITING;
+#if (I2C1_DMA != 0)
+    i2c1_dma_end();
+#endif
+
+    end_i2c1_wr(true);
+    TRACE_end();
+}
+
+static void i2c1_ev_unknown(void)
+{
+    // No slave event flag is set, nothing to acknowledge
+    i2c1_ev_unknown_cnt++;
+}
+
+// Several flags at once are handled in bus order: data, STOP, new address
+static void i2c1_ev_stop_addr(void)    { i2c1_ev_stop(); i2c1_ev_addr(); }
+static void i2c1_ev_rx_addr(void)      { i2c1_ev_rx(); i2c1_ev_addr(); }
+static void i2c1_ev_rx_stop(void)      { i2c1_ev_rx(); i2c1_ev_stop(); }
+static void i2c1_ev_rx_stop_addr(void) { i2c1_ev_rx(); i2c1_ev_stop(); i2c1_ev_addr(); }
+
+/*******************************************************************/
+// Table index from SR1: bit0 - ADDR, bit1 - STOPF, bit2 - RXNE, bit3 - TXE
+#define I2C1_EV_IDX(sr1) (0                           \
+                          | (((sr1) >> 1) & 0x01)     \
+                          | (((sr1) >> 3) & 0x02)     \
+                          | (((sr1) >> 4) & 0x0C)     \
+                         )
+
+static void (* const i2c1_ev_table[16])(void) =
+{
+    [0x0] = i2c1_ev_unknown,
+    [0x1] = i2c1_ev_addr,
+    [0x2] = i2c1_ev_stop,
+    [0x3] = i2c1_ev_stop_addr,
+    [0x4] = i2c1_ev_rx,
+    [0x5] = i2c1_ev_rx_addr,
+    [0x6] = i2c1_ev_rx_stop,
+    [0x7] = i2c1_ev_rx_stop_addr,
+    // TXE: ADDR sends the first byte itself, after STOP nothing is sent
+    [0x8] = i2c1_ev_tx,
+    [0x9] = i2c1_ev_addr,
+    [0xA] = i2c1_ev_stop,
+    [0xB] = i2c1_ev_stop_addr,
+    // TXE and RXNE are exclusive, RXNE wins
+    [0xC] = i2c1_ev_rx,
+    [0xD] = i2c1_ev_rx_addr,
+    [0xE] = i2c1_ev_rx_stop,
+    [0xF] = i2c1_ev_rx_stop_addr,
+};
+
+#if (PROF_ENABLE != 0)
+// Profiling class of each table entry, combined events count as the first one
+static const uint8_t i2c1_ev_prof[16] =
+{
+    PROF_EV_UNKNOWN, PROF_EV_ADDR, PROF_EV_STOP, PROF_EV_STOP,
+    PROF_EV_RX,      PROF_EV_RX,   PROF_EV_RX,   PROF_EV_RX,
+    PROF_EV_TX,      PROF_EV_ADDR, PROF_EV_STOP, PROF_EV_STOP,
+    PROF_EV_RX,      PROF_EV_RX,   PROF_EV_RX,   PROF_EV_RX,
+};
+#endif
+
+/*******************************************************************/
+void I2C1_EV_IRQHandler(void)
+{
+    PROF_START();
+    // Single read of SR1, SR2 is only needed for ADDR
+    uint16_t sr1 = I2C1->SR1;
+
+    i2c1_ev_table[I2C1_EV_IDX(sr1)]();
+
+    PROF_STOP(i2c1_ev_prof[I2C1_EV_IDX(sr1)]);
+}
+
 /*******************************************************************/
 void I2C1_ER_IRQHandler(void)
 {
+    PROF_START();
+
     if (I2C_GetITStatus(I2C1, I2C_IT_AF))
     {
         I2C_ClearITPendingBit(I2C1, I2C_IT_AF);
+#if (I2C1_DMA != 0)
+        if (i2c1_dma_ch != NULL)
+        {
+            // NACK of the master ends the read transfer
+            i2c1_dma_end();
+        }
+        else
+#endif
+        // The byte loaded after the last ACK has not been clocked out, the
+        // pointer stays on it like in the device (same as the DMA path).
+        // DMA builds get here for reads outside of the bank (PROF window).
+        if ((I2C1->SR1 & I2C_SR1_TXE) == 0)
+        {
+            i2c1_bank_cur->adr = i2c1_tx_adr;
+            TRACE_unsent();
+        }
+        // No STOPF follows the NACK of a read, the transaction ends here
+        TRACE_end();
+        i2c1_mode = I2C1_MODE_WAITING;
     }
+
+    if (I2C_GetITStatus(I2C1, I2C_IT_BERR) || I2C_GetITStatus(I2C1, I2C_IT_OVR))
+    {
+        // Misplaced START/STOP or a lost byte: the write is not committed
+        TRACE_error((I2C_GetITStatus(I2C1, I2C_IT_BERR) ? TRACE_ERR_BERR : 0)
+                    | (I2C_GetITStatus(I2C1, I2C_IT_OVR) ? TRACE_ERR_OVR : 0));
+        I2C_ClearITPendingBit(I2C1, I2C_IT_BERR | I2C_IT_OVR);
+#if (I2C1_DMA != 0)
+        i2c1_dma_end();
+#endif
+        end_i2c1_wr(false);
+        TRACE_end();
+        i2c1_mode = I2C1_MODE_WAITING;
+    }
+
+    PROF_STOP(PROF_EV_ERR);
+}
+
+#if (I2C1_DMA != 0)
+/*******************************************************************/
+// The register bank is exhausted, the rest of the burst is served per byte
+void DMA1_Channel6_IRQHandler(void)
+{
+    uint8_t cnt;
+
+    DMA_ClearITPendingBit(DMA1_IT_TC6);
+    cnt = i2c1_dma_stop();
+    trace_i2c1_tx(cnt);
+    // The last byte may still wait in DR when the master NACKs
+    i2c1_tx_adr = i2c1_bank_cur->adr + cnt - 1;
+    i2c1_bank_cur->adr = add_i2c1_adr(i2c1_bank_cur, cnt);
+    // Long reads continue after the pointer has wrapped
+    i2c1_dma_start(DMA1_Channel6);
+}
+
+void DMA1_Channel7_IRQHandler(void)
+{
+    DMA_ClearITPendingBit(DMA1_IT_TC7);
+    i2c1_dma_end();
 }
+#endif
 /*******************************************************************/
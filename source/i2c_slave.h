@@ -1,11 +1,21 @@
 // see: https://blog.avislab.com/stm32-i2c-slave_ru/
 
+#ifndef I2C_SLAVE_H
+#define I2C_SLAVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "event_queue.h"
+
 /*******************************************************************/
 #define I2CSLAVE_ADDR1      0x68   // DS3231
 #define I2CSLAVE_ADDR2      0x48   // ADS1115
 
 #define   I2C1_CLOCK_FRQ    400000 // I2C-Frq in Hz (400 kHz)
-#define   I2C1_RAM_SIZE     0x100  // RAM Size in Byte (0...255)
+#ifndef I2C1_DMA
+    #define I2C1_DMA        0      // Data bytes by DMA1 ch6/ch7 (1) or one interrupt per byte (0)
+#endif
 
 typedef enum
 {
@@ -17,8 +27,59 @@ typedef enum
     I2C1_MODE_DATA_BYTE_RD, // Data byte (to read)
 } I2C1_MODE_t;
 
+typedef enum
+{
+    I2C1_DEV_DS3231,        // I2CSLAVE_ADDR1
+    I2C1_DEV_ADS1115,       // I2CSLAVE_ADDR2
+    I2C1_DEV_CNT,
+} I2C1_DEV_t;
+
+// Register descriptor, one per byte address in a flash-resident table
+typedef struct
+{
+    uint8_t reset;          // Power-on value
+    uint8_t wmask;          // Bits written by the master
+    uint8_t w0c;            // Bits cleared by writing 0, writing 1 keeps them
+    uint8_t hook;           // Side effect id of the device, posted to the main loop
+} I2C1_REG_t;
+
+#define I2C1_HOOK_NONE      0      // Write without side effect, not posted
+
+// Table entry and compile-time checks from a register list of the form
+// REG(adr, reset, wmask, w0c, hook)
+#define I2C1_REG_DESC(adr, reset, wmask, w0c, hook) [adr] = {reset, wmask, w0c, hook},
+#define I2C1_REG_BIT(adr, reset, wmask, w0c, hook)  | (1ULL << (adr))
+#define I2C1_REG_ONE(adr, reset, wmask, w0c, hook)  + 1
+#define I2C1_REG_W0C(adr, reset, wmask, w0c, hook)  | ((wmask) & (w0c))
+
+// Every address 0...size-1 listed exactly once, w0c bits are not writable
+#define I2C1_REG_CHECK(name, list, size)                                          \
+    typedef char name##_covered[((0 list(I2C1_REG_BIT)) == (1ULL << (size)) - 1) ? 1 : -1]; \
+    typedef char name##_unique[((0 list(I2C1_REG_ONE)) == (size)) ? 1 : -1];      \
+    typedef char name##_w0c[((0 list(I2C1_REG_W0C)) == 0) ? 1 : -1]
+
+typedef struct
+{
+    uint8_t *ram;           // Register bank of the device
+    const I2C1_REG_t *reg;  // Register descriptors, size entries
+    uint8_t  size;          // Bank size in Byte
+    uint8_t  ptr_mask;      // Register pointer bits of the address byte
+    uint8_t  ptr_shift;     // Register pointer to byte address
+    uint8_t  inc_mask;      // Byte address bits advanced by a burst
+    uint8_t  adr;           // Current register address of the device
+    void (*start)(bool);    // START with the device address (read), runs in the ISR (optional)
+    void (*event)(const EVQ_ITEM_t *); // Hooks of a committed write, run by the main loop
+} I2C1_BANK_t;
+
 /*******************************************************************/
 
+extern I2C1_BANK_t i2c1_bank[I2C1_DEV_CNT];
+extern uint32_t i2c1_ev_unknown_cnt;
+
 void I2C1_Slave_init(void);
+void I2C1_Slave_poll(void);
+bool I2C1_Slave_idle(void);
+
+#endif // I2C_SLAVE_H
 
 /*******************************************************************/
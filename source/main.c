@@ -13,6 +13,14 @@
 #include <stdio.h>
 
 #include "i2c_slave.h"
+#include "ds3231.h"
+#include "ads1115.h"
+#include "event_queue.h"
+#include "prof.h"
+#include "trace.h"
+
+#include "RTE_Components.h"
+#include CMSIS_device_header
 
 #if !defined(__CC_ARM) && defined(__ARMCC_VERSION) && !defined(__OPTIMIZE__)
     /*
@@ -23,6 +31,34 @@
     __asm(".global __ARM_use_no_argv\n\t" "__ARM_use_no_argv:\n\t");
 #endif
 
+/// Cycles spent asleep in the superloop
+volatile uint32_t cpu_idle_cyc = 0;
+
+/**
+ * @brief   Sleep until the next interrupt if no work is pending
+ * @details Interrupts are masked between the check and WFI, so an event
+ *          posted in between still wakes the core up. The handler runs
+ *          after the unmasking and is not counted as idle time.
+ */
+static void idle(void)
+{
+    uint32_t cyc;
+
+    __disable_irq();
+
+    if (I2C1_Slave_idle())
+    {
+        cyc = DWT->CYCCNT;
+        __WFI();
+        cpu_idle_cyc += DWT->CYCCNT - cyc;
+    }
+
+    // Still masked: a snapshot of the page never splits idle and cycles
+    PROF_idle(cpu_idle_cyc);
+
+    __enable_irq();
+}
+
 /**
  * @brief   Main function
  * @details Init peripherial modules and starting superloop
@@ -31,11 +67,22 @@
  */
 int main(void)
 {
+    /* Boot time is measured from here */
+    PROF_init();
+
+    /* All preemption levels, no subpriorities */
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_4);
+
+    DS3231_init();
+    ADS1115_init();
+    TRACE_init();
     I2C1_Slave_init();
 
     for(;;)
     {
-        
+        I2C1_Slave_poll();
+        TRACE_poll();
+        idle();
     }
 }
 
@@ -0,0 +1,119 @@
+#include <string.h>
+
+#include "prof.h"
+#include "calendar.h"
+
+#if (PROF_ENABLE != 0)
+
+/*******************************************************************/
+PROF_PAGE_t prof_page;
+// Copy read by the master, taken at the START of a read of the window
+static PROF_PAGE_t prof_snap;
+
+/*******************************************************************/
+// Calendar conversions of a time set and of a restore from the backup
+// domain, timed once at boot with the interrupts masked. The dates span
+// the 136 years of the 32 bit epoch.
+static void prof_calendar(void)
+{
+    static const uint8_t dates[][3] = {{0, 1, 1}, {20, 2, 29}, {99, 12, 31}, {135, 12, 31}};
+    uint8_t hms[3];
+    uint8_t year, month, date;
+    uint32_t days;
+    uint32_t cyc;
+
+    __disable_irq();
+    for (uint8_t i = 0; i < sizeof(dates) / sizeof(dates[0]); i++)
+    {
+        cyc = DWT->CYCCNT;
+        days = CALENDAR_days(dates[i][0], dates[i][1], dates[i][2]);
+        cyc = DWT->CYCCNT - cyc;
+        if (cyc > prof_page.cal_days) prof_page.cal_days = cyc;
+
+        cyc = DWT->CYCCNT;
+        days = CALENDAR_split(days * 86400 + 86399, hms);
+        CALENDAR_date(days, &year, &month, &date);
+        cyc = DWT->CYCCNT - cyc;
+        if (cyc > prof_page.cal_date) prof_page.cal_date = cyc;
+    }
+    __enable_irq();
+}
+
+/*******************************************************************/
+void PROF_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    prof_calendar();
+}
+
+/*******************************************************************/
+void PROF_record(PROF_EV_t ev, uint32_t cyc)
+{
+    PROF_STAT_t *stat = &prof_page.ev[ev];
+    uint16_t val = (cyc > 0xFFFF) ? 0xFFFF : cyc;
+    uint32_t bin = (cyc == 0) ? 0 : 31 - __CLZ(cyc);
+
+    if (stat->cnt == 0)
+    {
+        stat->min = val;
+        stat->mean = val;
+    }
+    else
+    {
+        stat->mean += ((int32_t)val - stat->mean) / 16;
+    }
+
+    if (val < stat->min) stat->min = val;
+    if (val > stat->max) stat->max = val;
+    stat->cnt++;
+
+    prof_page.hist[(bin < PROF_HIST_SIZE) ? bin : PROF_HIST_SIZE - 1]++;
+}
+
+/*******************************************************************/
+// The events of the read itself would change the page under the master
+void PROF_snapshot(void)
+{
+    prof_snap = prof_page;
+}
+
+uint8_t PROF_read(uint8_t adr)
+{
+    return (adr < sizeof(prof_snap)) ? ((const uint8_t *)&prof_snap)[adr] : 0xFF;
+}
+
+// The boot time and the calendar cycles are only measured once
+void PROF_clear(void)
+{
+    uint32_t boot = prof_page.boot;
+    uint16_t cal_days = prof_page.cal_days;
+    uint16_t cal_date = prof_page.cal_date;
+
+    memset(&prof_page, 0, sizeof(prof_page));
+    prof_page.boot = boot;
+    prof_page.cal_days = cal_days;
+    prof_page.cal_date = cal_date;
+}
+
+// CPU load over a period: 1 - (idle delta / cycles delta)
+void PROF_idle(uint32_t idle)
+{
+    prof_page.idle = idle;
+    prof_page.cycles = DWT->CYCCNT;
+}
+
+// Boot time up to the first ACK, PROF_init is the first call of main
+void PROF_boot(void)
+{
+    if (prof_page.boot == 0)
+    {
+        prof_page.boot = DWT->CYCCNT;
+    }
+}
+
+#endif // PROF_ENABLE
+
+/*******************************************************************/
@@ -0,0 +1,86 @@
+// Cycle profiling of the I2C interrupts with the DWT cycle counter
+// The statistics are readable over I2C in the DS3231 register map at
+// PROF_REG_BASE (a copy taken at the START of the read), writing any byte
+// there clears them.
+
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+
+/*******************************************************************/
+#ifndef PROF_ENABLE
+    #ifdef NDEBUG
+        #define PROF_ENABLE     0      // Release: compiled out
+    #else
+        #define PROF_ENABLE     1
+    #endif
+#endif
+
+#define PROF_REG_BASE           0x80   // Diagnostic window (0x80...0xFF)
+#define PROF_HIST_SIZE          16     // log2 bins: [2^n, 2^(n+1)) cycles
+
+typedef enum
+{
+    PROF_EV_ADDR,           // Address matched
+    PROF_EV_RX,             // Byte received
+    PROF_EV_TX,             // Byte transmitted
+    PROF_EV_STOP,           // STOP detected
+    PROF_EV_UNKNOWN,        // No slave event flag
+    PROF_EV_ERR,            // I2C1_ER_IRQHandler
+    PROF_EV_CNT,
+} PROF_EV_t;
+
+// Little-endian, as seen by the master
+typedef struct
+{
+    uint16_t min;           // cycles
+    uint16_t max;           // cycles
+    uint16_t mean;          // cycles, moving average over 16 events
+    uint16_t rsv;
+    uint32_t cnt;           // number of events
+} PROF_STAT_t;
+
+typedef struct
+{
+    PROF_STAT_t ev[PROF_EV_CNT];
+    uint16_t hist[PROF_HIST_SIZE];
+    uint32_t idle;          // cycles slept by the main loop
+    uint32_t cycles;        // cycle counter at the last idle update
+    uint32_t boot;          // cycles from PROF_init to the first address match
+    uint16_t cal_days;      // cycles of CALENDAR_days, worst of a few dates
+    uint16_t cal_date;      // cycles of CALENDAR_split + CALENDAR_date
+} PROF_PAGE_t;
+
+/*******************************************************************/
+#if (PROF_ENABLE != 0)
+
+#include "RTE_Components.h"
+#include CMSIS_device_header
+
+extern PROF_PAGE_t prof_page;
+
+void PROF_init(void);
+void PROF_record(PROF_EV_t ev, uint32_t cyc);
+void PROF_snapshot(void);
+uint8_t PROF_read(uint8_t adr);
+void PROF_clear(void);
+void PROF_idle(uint32_t idle);
+void PROF_boot(void);
+
+#define PROF_START()            uint32_t prof_cyc = DWT->CYCCNT
+#define PROF_STOP(ev)           PROF_record((ev), DWT->CYCCNT - prof_cyc)
+
+#else
+
+#define PROF_init()
+#define PROF_idle(idle)
+#define PROF_boot()
+#define PROF_START()
+#define PROF_STOP(ev)
+
+#endif // PROF_ENABLE
+
+#endif // PROF_H
+
+/*******************************************************************/
@@ -0,0 +1,367 @@
+#include "trace.h"
+
+#if (TRACE_ENABLE != 0)
+
+#include "RTE_Components.h"
+#include CMSIS_device_header
+
+/*******************************************************************/
+#define TRACE_REC_MAX           (1 + 4 + 1 + 1 + 1 + TRACE_DATA)   // Bytes of one record
+// COBS adds one byte per 254 and the delimiter
+#define TRACE_TX_SIZE           (1 + TRACE_FRAME + (1 + TRACE_FRAME) / 254 + 1 + 1)
+
+#define TRACE_UART_PORT         GPIOA
+#define TRACE_UART_PIN          GPIO_Pin_9
+#define TRACE_DMA_CH            DMA1_Channel4  // USART1_TX
+
+typedef char trace_size_pow2[((TRACE_SIZE & (TRACE_SIZE - 1)) == 0) ? 1 : -1];
+
+// Free-running byte indices: head and tail are written by the producer
+// only, the oldest records are overwritten. The main loop exports from
+// its own index and detects overwritten bytes by the tail.
+static uint8_t trace_ring[TRACE_SIZE];
+static volatile uint32_t trace_head = 0;
+static volatile uint32_t trace_tail = 0;
+static uint32_t trace_rd = 0;               // Main loop only
+static bool trace_lost = false;             // Main loop only
+static bool trace_boot = true;              // Main loop only
+
+// Time base of the deltas and the pointer of the last record per device,
+// producer only
+static uint32_t trace_last;
+static uint8_t trace_ptr_last[2];
+
+// Transaction in progress, I2C interrupts only
+static struct
+{
+    bool     open;
+    bool     read;
+    uint8_t  dev;
+    uint8_t  ptr;
+    uint8_t  len;
+    uint8_t  err;
+    uint32_t time;
+    uint8_t  data[TRACE_DATA];
+} trace_cur;
+
+static uint8_t trace_tx[TRACE_TX_SIZE];
+static volatile bool trace_tx_busy = false;     // Frame in the DMA
+
+/*******************************************************************/
+static uint8_t trace_at(uint32_t pos)
+{
+    return trace_ring[pos & (TRACE_SIZE - 1)];
+}
+
+// Size of the record at pos
+static uint8_t trace_rec_len(uint32_t pos)
+{
+    uint8_t hdr = trace_at(pos);
+    uint8_t n = 1;
+    uint8_t len = hdr & TRACE_HDR_LEN;
+
+    // Time delta: 4 bytes at most
+    while ((trace_at(pos + n) & 0x80) && n < 4)
+    {
+        n++;
+    }
+    n++;
+    if (hdr & TRACE_HDR_PTR) n++;
+    if (len == TRACE_HDR_LEN) len = trace_at(pos + n++);
+    if (hdr & TRACE_HDR_ERR) n++;
+
+    return n + ((len < TRACE_DATA) ? len : TRACE_DATA);
+}
+
+// Appends a record, the oldest records make room for it
+static void trace_put(const uint8_t *rec, uint8_t n)
+{
+    uint32_t head = trace_head;
+    uint32_t tail = trace_tail;
+
+    while (head + n - tail > TRACE_SIZE)
+    {
+        tail += trace_rec_len(tail);
+    }
+    // The reader must see the tail move before the bytes change
+    trace_tail = tail;
+    __DMB();
+
+    for (uint8_t i = 0; i < n; i++)
+    {
+        trace_ring[(head + i) & (TRACE_SIZE - 1)] = rec[i];
+    }
+
+    __DMB();
+    trace_head = head + n;
+}
+
+// Time since the last record in TRACE_TIME_SHIFT units as LEB128
+static uint8_t trace_time(uint8_t *rec, uint32_t time)
+{
+    uint32_t delta = (time - trace_last) >> TRACE_TIME_SHIFT;
+    uint8_t n = 0;
+
+    // Rounding is not accumulated
+    trace_last += delta << TRACE_TIME_SHIFT;
+
+    while (delta >= 0x80)
+    {
+        rec[n++] = (uint8_t)delta | 0x80;
+        delta >>= 7;
+    }
+    rec[n++] = (uint8_t)delta;
+
+    return n;
+}
+
+/*******************************************************************/
+void TRACE_init(void)
+{
+    GPIO_InitTypeDef  GPIO_InitStructure;
+    USART_InitTypeDef USART_InitStructure;
+    DMA_InitTypeDef   DMA_InitStructure;
+    NVIC_InitTypeDef  NVIC_InitStructure;
+
+    // Timestamps come from the DWT cycle counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    trace_last = DWT->CYCCNT;
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1 | RCC_APB2Periph_GPIOA, ENABLE);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    /* USART1 TX only, PA2/PA3 of USART2 are analog inputs */
+    GPIO_InitStructure.GPIO_Pin = TRACE_UART_PIN;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+    GPIO_Init(TRACE_UART_PORT, &GPIO_InitStructure);
+
+    USART_InitStructure.USART_BaudRate = TRACE_UART_BAUD;
+    USART_InitStructure.USART_WordLength = USART_WordLength_8b;
+    USART_InitStructure.USART_StopBits = USART_StopBits_1;
+    USART_InitStructure.USART_Parity = USART_Parity_No;
+    USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    USART_InitStructure.USART_Mode = USART_Mode_Tx;
+    USART_Init(USART1, &USART_InitStructure);
+    USART_DMACmd(USART1, USART_DMAReq_Tx, ENABLE);
+    USART_Cmd(USART1, ENABLE);
+
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&USART1->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)trace_tx;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = 1;     // set on each frame
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(TRACE_DMA_CH, &DMA_InitStructure);
+    DMA_ITConfig(TRACE_DMA_CH, DMA_IT_TC, ENABLE);
+
+    /* The end of a frame wakes up the main loop for the next one */
+    NVIC_InitStructure.NVIC_IRQChannel                   = DMA1_Channel4_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 15;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority        = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd                = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+}
+
+/*******************************************************************/
+void TRACE_start(uint8_t dev, bool read, uint8_t ptr)
+{
+    trace_cur.open = true;
+    trace_cur.read = read;
+    trace_cur.dev = dev;
+    trace_cur.ptr = ptr;
+    trace_cur.len = 0;
+    trace_cur.err = 0;
+    trace_cur.time = DWT->CYCCNT;
+}
+
+void TRACE_ptr(uint8_t ptr)
+{
+    trace_cur.ptr = ptr;
+}
+
+void TRACE_byte(uint8_t val)
+{
+    if (trace_cur.len < TRACE_DATA)
+    {
+        trace_cur.data[trace_cur.len] = val;
+    }
+    if (trace_cur.len < 0xFF)
+    {
+        trace_cur.len++;
+    }
+}
+
+// The last byte loaded for the master has not been clocked out
+void TRACE_unsent(void)
+{
+    if (trace_cur.len != 0 && trace_cur.len < 0xFF)
+    {
+        trace_cur.len--;
+    }
+}
+
+void TRACE_error(uint8_t err)
+{
+    trace_cur.err |= err;
+}
+
+// STOP, NACK of a read, repeated START or bus error
+void TRACE_end(void)
+{
+    uint8_t rec[TRACE_REC_MAX];
+    uint8_t hdr = (trace_cur.read ? TRACE_HDR_READ : 0) | (trace_cur.dev ? TRACE_HDR_DEV : 0);
+    uint8_t n = 1;
+
+    if (!trace_cur.open)
+    {
+        return;
+    }
+    trace_cur.open = false;
+
+    n += trace_time(&rec[n], trace_cur.time);
+    if (trace_cur.ptr != trace_ptr_last[trace_cur.dev & 1])
+    {
+        trace_ptr_last[trace_cur.dev & 1] = trace_cur.ptr;
+        hdr |= TRACE_HDR_PTR;
+        rec[n++] = trace_cur.ptr;
+    }
+    if (trace_cur.len < TRACE_HDR_LEN)
+    {
+        hdr |= trace_cur.len;
+    }
+    else
+    {
+        hdr |= TRACE_HDR_LEN;
+        rec[n++] = trace_cur.len;
+    }
+    if (trace_cur.err != 0)
+    {
+        hdr |= TRACE_HDR_ERR;
+        rec[n++] = trace_cur.err;
+    }
+    for (uint8_t i = 0; i < trace_cur.len && i < TRACE_DATA; i++)
+    {
+        rec[n++] = trace_cur.data[i];
+    }
+    rec[0] = hdr;
+
+    trace_put(rec, n);
+}
+
+/*******************************************************************/
+// COBS: no 0x00 in the frame, which ends with one
+static uint8_t trace_cobs(const uint8_t *src, uint8_t len, uint8_t *dst)
+{
+    uint8_t code = 0;   // Position of the current code byte
+    uint8_t n = 1;
+
+    for (uint8_t i = 0; i < len; i++)
+    {
+        if (src[i] != 0)
+        {
+            dst[n++] = src[i];
+        }
+        if (src[i] == 0 || n - code == 0xFF)
+        {
+            dst[code] = n - code;
+            code = n++;
+        }
+    }
+    dst[code] = n - code;
+    dst[n++] = 0;
+
+    return n;
+}
+
+// Exports the next frame when the previous one is out
+void TRACE_poll(void)
+{
+    uint8_t frame[1 + TRACE_FRAME];
+    uint32_t head = trace_head;
+    uint32_t rd = trace_rd;
+    uint8_t n = 0;
+
+    // Long idle: the cycle counter must not run a full turn between records
+    if (DWT->CYCCNT - trace_last >= 0x80000000)
+    {
+        __disable_irq();
+        if (!trace_cur.open)
+        {
+            uint8_t rec[1 + 4 + 1] = {TRACE_HDR_ERR};
+            uint8_t len = 1 + trace_time(&rec[1], DWT->CYCCNT);
+
+            rec[len++] = TRACE_ERR_IDLE;
+            trace_put(rec, len);
+            head = trace_head;
+        }
+        __enable_irq();
+    }
+
+    if (trace_tx_busy)
+    {
+        return;
+    }
+
+    if ((int32_t)(trace_tail - rd) > 0)
+    {
+        rd = trace_tail;
+        trace_lost = true;
+    }
+
+    // Whole records only, the sizes are checked again by the tail below
+    while (rd + n != head)
+    {
+        uint8_t len = trace_rec_len(rd + n);
+
+        if (n + len > TRACE_FRAME || head - (rd + n) < len)
+        {
+            break;
+        }
+        n += len;
+    }
+
+    if (n == 0 && !trace_lost)
+    {
+        return;
+    }
+
+    frame[0] = (trace_lost ? TRACE_FRAME_LOST : 0) | (trace_boot ? TRACE_FRAME_BOOT : 0);
+    for (uint8_t i = 0; i < n; i++)
+    {
+        frame[1 + i] = trace_at(rd + i);
+    }
+
+    // Overwritten while copying: start over at the new tail
+    __DMB();
+    if ((int32_t)(trace_tail - rd) > 0)
+    {
+        trace_lost = true;
+        return;
+    }
+    trace_rd = rd + n;
+    trace_lost = false;
+    trace_boot = false;
+
+    trace_tx_busy = true;
+    DMA_Cmd(TRACE_DMA_CH, DISABLE);
+    DMA_SetCurrDataCounter(TRACE_DMA_CH, trace_cobs(frame, 1 + n, trace_tx));
+    DMA_Cmd(TRACE_DMA_CH, ENABLE);
+}
+
+/*******************************************************************/
+void DMA1_Channel4_IRQHandler(void)
+{
+    DMA_ClearITPendingBit(DMA1_IT_TC4);
+    trace_tx_busy = false;
+}
+
+#endif // TRACE_ENABLE
+
+/*******************************************************************/
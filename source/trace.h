@@ -0,0 +1,78 @@
+// Bus transaction trace: every I2C transaction is logged into a RAM ring
+// by the I2C interrupts (single producer, no locking) and streamed over
+// the USART1 TX pin (PA9) by the main loop. Decoder: tools/trace_decode.py
+//
+// Record, delta-encoded:
+//   header   bit 7: read, bit 6: second device (ADS1115), bit 5: error byte,
+//            bit 4: pointer byte (else same as the last record of the
+//            device), bits 3...0: length 0...14, 15: length byte
+//   time     cycles / 2^TRACE_TIME_SHIFT since the last record, LEB128
+//   pointer  register byte address at the start (optional)
+//   length   data bytes, saturated at 255 (optional)
+//   error    TRACE_ERR_xxx (optional)
+//   data     first data bytes, up to TRACE_DATA
+//
+// Export frames are COBS encoded with a 0x00 delimiter, each holds a flag
+// byte (TRACE_FRAME_xxx) and whole records.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************/
+#ifndef TRACE_ENABLE
+    #define TRACE_ENABLE        1      // Also in release, it is the flight recorder
+#endif
+
+#define TRACE_SIZE              8192   // Ring in Byte, power of 2 (1000...2700 records)
+#define TRACE_DATA              4      // Data bytes kept per record
+#define TRACE_TIME_SHIFT        6      // Time unit: 64 cycles, 0.89 us at 72 MHz
+#define TRACE_UART_BAUD         115200
+#define TRACE_FRAME             64     // Record bytes per export frame
+
+#define TRACE_HDR_READ          0x80
+#define TRACE_HDR_DEV           0x40
+#define TRACE_HDR_ERR           0x20
+#define TRACE_HDR_PTR           0x10
+#define TRACE_HDR_LEN           0x0F   // TRACE_HDR_LEN: length byte follows
+
+#define TRACE_ERR_BERR          0x01   // Misplaced START/STOP
+#define TRACE_ERR_OVR           0x02   // Overrun/underrun
+#define TRACE_ERR_LOST          0x04   // Write bytes dropped on a full event queue
+#define TRACE_ERR_IDLE          0x80   // No transaction, only keeps the time base
+
+#define TRACE_FRAME_LOST        0x01   // Records were overwritten before the export
+#define TRACE_FRAME_BOOT        0x02   // First frame, the time is counted from TRACE_init
+
+/*******************************************************************/
+#if (TRACE_ENABLE != 0)
+
+void TRACE_init(void);
+void TRACE_poll(void);
+
+// I2C interrupts only
+void TRACE_start(uint8_t dev, bool read, uint8_t ptr);
+void TRACE_ptr(uint8_t ptr);
+void TRACE_byte(uint8_t val);
+void TRACE_unsent(void);
+void TRACE_error(uint8_t err);
+void TRACE_end(void);
+
+#else
+
+#define TRACE_init()
+#define TRACE_poll()
+#define TRACE_start(dev, read, ptr)
+#define TRACE_ptr(ptr)
+#define TRACE_byte(val)
+#define TRACE_unsent()
+#define TRACE_error(err)
+#define TRACE_end()
+
+#endif // TRACE_ENABLE
+
+#endif // TRACE_H
+
+/*******************************************************************/
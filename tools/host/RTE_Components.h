@@ -0,0 +1,8 @@
+// Host build of the firmware sources, see stm32f10x.h
+
+#ifndef RTE_COMPONENTS_H
+#define RTE_COMPONENTS_H
+
+#define CMSIS_device_header "stm32f10x.h"
+
+#endif // RTE_COMPONENTS_H
@@ -0,0 +1,632 @@
+// Host model of I2C1, DMA1 ch6/ch7, the NVIC and the RTC, see i2c_host.h
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "i2c_host.h"
+#include "i2c_slave.h"
+#include "ds3231.h"
+#include "ads1115.h"
+#include "prof.h"
+#include "trace.h"
+
+/*******************************************************************/
+uint32_t host_errors = 0;
+uint32_t host_irq_cnt[HOST_IRQ_CNT];
+void (*host_byte_hook)(uint32_t n) = NULL;
+
+uint32_t SystemCoreClock = 72000000;
+
+static CoreDebug_Type core_debug;
+static DWT_Type dwt;
+static I2C_TypeDef i2c1;
+static DMA_Channel_TypeDef dma1_channel[8];
+static GPIO_TypeDef gpioa, gpiob;
+static RCC_TypeDef rcc;
+static ADC_TypeDef adc1;
+static USART_TypeDef usart1;
+static TIM_TypeDef tim2, tim3, tim4;
+
+CoreDebug_Type *CoreDebug = &core_debug;
+DWT_Type *DWT = &dwt;
+I2C_TypeDef *I2C1 = &i2c1;
+DMA_Channel_TypeDef *DMA1_Channel1 = &dma1_channel[1];
+DMA_Channel_TypeDef *DMA1_Channel4 = &dma1_channel[4];
+DMA_Channel_TypeDef *DMA1_Channel6 = &dma1_channel[6];
+DMA_Channel_TypeDef *DMA1_Channel7 = &dma1_channel[7];
+GPIO_TypeDef *GPIOA = &gpioa;
+GPIO_TypeDef *GPIOB = &gpiob;
+RCC_TypeDef *RCC = &rcc;
+ADC_TypeDef *ADC1 = &adc1;
+USART_TypeDef *USART1 = &usart1;
+TIM_TypeDef *TIM2 = &tim2;
+TIM_TypeDef *TIM3 = &tim3;
+TIM_TypeDef *TIM4 = &tim4;
+
+// Own addresses, 7 bit
+static uint8_t i2c_oar1;
+static uint8_t i2c_oar2;
+static bool i2c_dual;
+
+// Transfer length of an enabled DMA channel, the memory index is
+// length - CNDTR like the address counter of the hardware
+static uint32_t dma_len[8];
+
+// Backup domain
+static uint16_t bkp_dr[16];
+static uint32_t rtc_cnt;
+static bool rtc_sec;
+static bool rcc_lserdy;
+
+void RTC_IRQHandler(void);
+void RCC_IRQHandler(void);
+void TIM2_IRQHandler(void);
+void DMA1_Channel1_IRQHandler(void);
+void DMA1_Channel6_IRQHandler(void);
+void DMA1_Channel7_IRQHandler(void);
+void I2C1_EV_IRQHandler(void);
+void I2C1_ER_IRQHandler(void);
+
+/*******************************************************************/
+static void host_error(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    host_errors++;
+}
+
+/*******************************************************************/
+// NVIC: preemption priorities only (NVIC_PriorityGroup_4), lower runs first
+#define NVIC_LEVEL_THREAD       0x100
+
+static void host_i2c1_ev(void);
+
+static void (* const nvic_handler[HOST_IRQ_CNT])(void) =
+{
+    [RTC_IRQn]           = RTC_IRQHandler,
+    [RCC_IRQn]           = RCC_IRQHandler,
+    [DMA1_Channel1_IRQn] = DMA1_Channel1_IRQHandler,
+#if (I2C1_DMA != 0)
+    [DMA1_Channel6_IRQn] = DMA1_Channel6_IRQHandler,
+    [DMA1_Channel7_IRQn] = DMA1_Channel7_IRQHandler,
+#endif
+    [TIM2_IRQn]          = TIM2_IRQHandler,
+    [I2C1_EV_IRQn]       = host_i2c1_ev,
+    [I2C1_ER_IRQn]       = I2C1_ER_IRQHandler,
+};
+
+static uint8_t nvic_prio[HOST_IRQ_CNT];
+static volatile bool nvic_enabled[HOST_IRQ_CNT];
+static volatile bool nvic_pending[HOST_IRQ_CNT];
+static volatile int nvic_level = NVIC_LEVEL_THREAD;
+static volatile bool nvic_primask = false;
+
+// Runs the pending interrupts that preempt the running context
+static void nvic_run(void)
+{
+    for (;;)
+    {
+        int irq = -1;
+        int level = nvic_level;
+
+        if (nvic_primask)
+        {
+            return;
+        }
+        for (int i = 0; i < HOST_IRQ_CNT; i++)
+        {
+            if (nvic_pending[i] && nvic_enabled[i] && nvic_prio[i] < level
+                && (irq < 0 || nvic_prio[i] < nvic_prio[irq]))
+            {
+                irq = i;
+            }
+        }
+        if (irq < 0)
+        {
+            return;
+        }
+
+        // Claimed like an exception entry, a master running from a signal
+        // handler may have taken it since the scan
+        if (!__atomic_exchange_n(&nvic_pending[irq], false, __ATOMIC_SEQ_CST))
+        {
+            continue;
+        }
+        if (nvic_handler[irq] == NULL)
+        {
+            host_error("IRQ %d without handler", irq);
+            continue;
+        }
+        host_irq_cnt[irq]++;
+        nvic_level = nvic_prio[irq];
+        nvic_handler[irq]();
+        nvic_level = level;
+    }
+}
+
+void NVIC_Init(NVIC_InitTypeDef *init)
+{
+    nvic_prio[init->NVIC_IRQChannel] = init->NVIC_IRQChannelPreemptionPriority;
+    nvic_enabled[init->NVIC_IRQChannel] = init->NVIC_IRQChannelCmd == ENABLE;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    nvic_enabled[irq] = true;
+    nvic_run();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    nvic_enabled[irq] = false;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irq)
+{
+    nvic_pending[irq] = true;
+    nvic_run();
+}
+
+void __disable_irq(void)
+{
+    nvic_primask = true;
+}
+
+void __enable_irq(void)
+{
+    nvic_primask = false;
+    nvic_run();
+}
+
+void NVIC_PriorityGroupConfig(uint32_t group) { (void)group; }
+
+// The I2C interrupts can run now, a master waits for them otherwise
+bool HOST_i2c_ready(void)
+{
+    return !nvic_primask && nvic_level > nvic_prio[I2C1_EV_IRQn]
+           && nvic_enabled[I2C1_EV_IRQn] && nvic_enabled[I2C1_ER_IRQn];
+}
+
+/*******************************************************************/
+// I2C1: SR1 flags are set by the bus, the handler clears them like on the
+// chip. Reading SR2 after SR1 clears ADDR (always done by the handler),
+// writing CR1 after SR1 clears STOPF (checked).
+static void host_i2c1_ev(void)
+{
+    uint16_t sr1 = I2C1->SR1;
+    uint16_t cr1 = I2C1->CR1;
+
+    if (sr1 & I2C_SR1_STOPF)
+    {
+        I2C1->CR1 = cr1 & ~I2C_CR1_PE;
+    }
+
+    I2C1_EV_IRQHandler();
+
+    I2C1->SR1 &= ~I2C_SR1_ADDR;
+    if (sr1 & I2C_SR1_STOPF)
+    {
+        if ((I2C1->CR1 & I2C_CR1_PE) == 0)
+        {
+            host_error("STOPF not cleared");
+        }
+        I2C1->CR1 = cr1;
+        I2C1->SR1 &= ~I2C_SR1_STOPF;
+    }
+}
+
+// A DMA request of I2C1 served, false if there is none
+static bool dma_move(void)
+{
+    DMA_Channel_TypeDef *tx = DMA1_Channel6;
+    DMA_Channel_TypeDef *rx = DMA1_Channel7;
+
+    if ((I2C1->CR2 & I2C_CR2_DMAEN) == 0)
+    {
+        return false;
+    }
+
+    if ((I2C1->SR1 & I2C_SR1_TXE) && (tx->CCR & DMA_CCR_EN) && tx->CNDTR != 0)
+    {
+        I2C1->DR = ((const uint8_t *)(uintptr_t)tx->CMAR)[dma_len[6] - tx->CNDTR];
+        I2C1->SR1 &= ~I2C_SR1_TXE;
+        if (--tx->CNDTR == 0 && (tx->CCR & DMA_CCR_TCIE))
+        {
+            NVIC_SetPendingIRQ(DMA1_Channel6_IRQn);
+        }
+        return true;
+    }
+
+    if ((I2C1->SR1 & I2C_SR1_RXNE) && (rx->CCR & DMA_CCR_EN) && rx->CNDTR != 0)
+    {
+        ((uint8_t *)(uintptr_t)rx->CMAR)[dma_len[7] - rx->CNDTR] = (uint8_t)I2C1->DR;
+        I2C1->SR1 &= ~I2C_SR1_RXNE;
+        if (--rx->CNDTR == 0 && (rx->CCR & DMA_CCR_TCIE))
+        {
+            NVIC_SetPendingIRQ(DMA1_Channel7_IRQn);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+// Serves the flags set by the bus until the slave has nothing left to do
+static void i2c_update(void)
+{
+    for (uint32_t n = 0; n < 16; n++)
+    {
+        uint16_t sr1 = I2C1->SR1;
+        uint16_t cr2 = I2C1->CR2;
+        IRQn_Type irq;
+
+        if (dma_move())
+        {
+            continue;
+        }
+
+        if ((cr2 & I2C_CR2_ITEVTEN)
+            && ((sr1 & (I2C_SR1_ADDR | I2C_SR1_STOPF))
+                || ((cr2 & I2C_CR2_ITBUFEN) && (sr1 & (I2C_SR1_TXE | I2C_SR1_RXNE)))))
+        {
+            irq = I2C1_EV_IRQn;
+        }
+        else if ((cr2 & I2C_CR2_ITERREN) && (sr1 & (I2C_SR1_BERR | I2C_SR1_AF | I2C_SR1_OVR)))
+        {
+            irq = I2C1_ER_IRQn;
+        }
+        else
+        {
+            return;
+        }
+
+        if (!HOST_i2c_ready())
+        {
+            host_error("I2C1 interrupt masked while the master waits, SR1 0x%04X", sr1);
+            return;
+        }
+        NVIC_SetPendingIRQ(irq);
+    }
+
+    host_error("I2C1 interrupt does not clear SR1 0x%04X", I2C1->SR1);
+    I2C1->SR1 = 0;
+}
+
+// Address byte of the master, false on NACK
+static bool i2c_start(uint8_t dev, bool read)
+{
+    bool dual = i2c_dual && dev == i2c_oar2;
+
+    if ((I2C1->CR1 & I2C_CR1_PE) == 0 || (dev != i2c_oar1 && !dual))
+    {
+        return false;
+    }
+
+    I2C1->SR2 = I2C_SR2_BUSY | (read ? I2C_SR2_TRA : 0) | (dual ? I2C_SR2_DUALF : 0);
+    I2C1->SR1 = (I2C1->SR1 & ~(I2C_SR1_TXE | I2C_SR1_RXNE)) | I2C_SR1_ADDR | (read ? I2C_SR1_TXE : 0);
+    i2c_update();
+
+    return true;
+}
+
+void I2C_Init(I2C_TypeDef *i2c, I2C_InitTypeDef *init)
+{
+    (void)i2c;
+    i2c_oar1 = (uint8_t)(init->I2C_OwnAddress1 >> 1);
+}
+
+void I2C_Cmd(I2C_TypeDef *i2c, FunctionalState state)
+{
+    i2c->CR1 = (state == ENABLE) ? (i2c->CR1 | I2C_CR1_PE) : (i2c->CR1 & ~I2C_CR1_PE);
+}
+
+void I2C_OwnAddress2Config(I2C_TypeDef *i2c, uint8_t adr)
+{
+    (void)i2c;
+    i2c_oar2 = adr >> 1;
+}
+
+void I2C_DualAddressCmd(I2C_TypeDef *i2c, FunctionalState state)
+{
+    (void)i2c;
+    i2c_dual = state == ENABLE;
+}
+
+void I2C_ITConfig(I2C_TypeDef *i2c, uint16_t it, FunctionalState state)
+{
+    i2c->CR2 = (state == ENABLE) ? (i2c->CR2 | it) : (i2c->CR2 & ~it);
+}
+
+void I2C_DMACmd(I2C_TypeDef *i2c, FunctionalState state)
+{
+    I2C_ITConfig(i2c, I2C_CR2_DMAEN, state);
+}
+
+void I2C_SendData(I2C_TypeDef *i2c, uint8_t val)
+{
+    i2c->DR = val;
+    i2c->SR1 &= ~I2C_SR1_TXE;
+}
+
+uint8_t I2C_ReceiveData(I2C_TypeDef *i2c)
+{
+    i2c->SR1 &= ~I2C_SR1_RXNE;
+    return (uint8_t)i2c->DR;
+}
+
+ITStatus I2C_GetITStatus(I2C_TypeDef *i2c, uint32_t it)
+{
+    return (i2c->SR1 & (uint16_t)it) ? SET : RESET;
+}
+
+void I2C_ClearITPendingBit(I2C_TypeDef *i2c, uint32_t it)
+{
+    i2c->SR1 &= ~(uint16_t)it;
+}
+
+/*******************************************************************/
+void DMA_Init(DMA_Channel_TypeDef *ch, DMA_InitTypeDef *init)
+{
+    ch->CCR = (ch->CCR & ~DMA_CCR_DIR) | init->DMA_DIR;
+    ch->CPAR = init->DMA_PeripheralBaseAddr;
+    ch->CMAR = init->DMA_MemoryBaseAddr;
+    ch->CNDTR = init->DMA_BufferSize;
+}
+
+void DMA_Cmd(DMA_Channel_TypeDef *ch, FunctionalState state)
+{
+    if (state == ENABLE)
+    {
+        ch->CCR |= DMA_CCR_EN;
+        dma_len[ch - dma1_channel] = ch->CNDTR;
+    }
+    else
+    {
+        ch->CCR &= ~DMA_CCR_EN;
+    }
+}
+
+void DMA_ITConfig(DMA_Channel_TypeDef *ch, uint32_t it, FunctionalState state)
+{
+    ch->CCR = (state == ENABLE) ? (ch->CCR | it) : (ch->CCR & ~it);
+}
+
+void DMA_SetCurrDataCounter(DMA_Channel_TypeDef *ch, uint16_t cnt)
+{
+    ch->CNDTR = cnt;
+}
+
+uint16_t DMA_GetCurrDataCounter(DMA_Channel_TypeDef *ch)
+{
+    return (uint16_t)ch->CNDTR;
+}
+
+ITStatus DMA_GetITStatus(uint32_t it) { (void)it; return RESET; }
+void DMA_ClearITPendingBit(uint32_t it) { (void)it; }
+
+/*******************************************************************/
+// Backup domain and RTC: the LSE is ready at once, seconds come from HOST_second
+void PWR_BackupAccessCmd(FunctionalState state) { (void)state; }
+
+uint16_t BKP_ReadBackupRegister(uint16_t reg)
+{
+    return bkp_dr[reg / 4];
+}
+
+void BKP_WriteBackupRegister(uint16_t reg, uint16_t val)
+{
+    bkp_dr[reg / 4] = val;
+}
+
+void RCC_BackupResetCmd(FunctionalState state)
+{
+    if (state == ENABLE)
+    {
+        memset(bkp_dr, 0, sizeof(bkp_dr));
+        RCC->BDCR = 0;
+        rtc_cnt = 0;
+    }
+}
+
+void RCC_ITConfig(uint8_t it, FunctionalState state)
+{
+    if (it == RCC_IT_LSERDY && state == ENABLE)
+    {
+        rcc_lserdy = true;
+        NVIC_SetPendingIRQ(RCC_IRQn);
+    }
+}
+
+ITStatus RCC_GetITStatus(uint8_t it)
+{
+    return (it == RCC_IT_LSERDY && rcc_lserdy) ? SET : RESET;
+}
+
+void RCC_ClearITPendingBit(uint8_t it)
+{
+    if (it == RCC_IT_LSERDY)
+    {
+        rcc_lserdy = false;
+    }
+}
+
+void RCC_RTCCLKCmd(FunctionalState state)
+{
+    RCC->BDCR = (state == ENABLE) ? (RCC->BDCR | RCC_BDCR_RTCEN) : (RCC->BDCR & ~RCC_BDCR_RTCEN);
+}
+
+uint32_t RTC_GetCounter(void)
+{
+    return rtc_cnt;
+}
+
+ITStatus RTC_GetITStatus(uint16_t it)
+{
+    return (it == RTC_IT_SEC && rtc_sec) ? SET : RESET;
+}
+
+void RTC_ClearITPendingBit(uint16_t it)
+{
+    if (it == RTC_IT_SEC)
+    {
+        rtc_sec = false;
+    }
+}
+
+void RCC_LSEConfig(uint8_t lse) { (void)lse; }
+void RCC_RTCCLKConfig(uint32_t source) { (void)source; }
+void RTC_WaitForSynchro(void) {}
+void RTC_WaitForLastTask(void) {}
+void RTC_SetPrescaler(uint32_t val) { (void)val; }
+void RTC_ITConfig(uint16_t it, FunctionalState state) { (void)it; (void)state; }
+void BKP_SetRTCCalibrationValue(uint8_t val) { (void)val; }
+
+/*******************************************************************/
+// Not modeled: clocks, pins, timers, ADC and the trace UART
+void RCC_AHBPeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_ADCCLKConfig(uint32_t div) { (void)div; }
+void GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init) { (void)port; (void)init; }
+void GPIO_PinRemapConfig(uint32_t remap, FunctionalState state) { (void)remap; (void)state; }
+void TIM_TimeBaseInit(TIM_TypeDef *tim, TIM_TimeBaseInitTypeDef *init) { (void)tim; (void)init; }
+void TIM_OCStructInit(TIM_OCInitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void TIM_OC1Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init) { (void)tim; (void)init; }
+void TIM_OC3Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init) { (void)tim; (void)init; }
+void TIM_SetCompare1(TIM_TypeDef *tim, uint16_t val) { (void)tim; (void)val; }
+void TIM_SelectOnePulseMode(TIM_TypeDef *tim, uint16_t mode) { (void)tim; (void)mode; }
+void TIM_Cmd(TIM_TypeDef *tim, FunctionalState state) { (void)tim; (void)state; }
+void TIM_ITConfig(TIM_TypeDef *tim, uint16_t it, FunctionalState state) { (void)tim; (void)it; (void)state; }
+ITStatus TIM_GetITStatus(TIM_TypeDef *tim, uint16_t it) { (void)tim; (void)it; return RESET; }
+void TIM_ClearITPendingBit(TIM_TypeDef *tim, uint16_t it) { (void)tim; (void)it; }
+void ADC_Init(ADC_TypeDef *adc, ADC_InitTypeDef *init) { (void)adc; (void)init; }
+void ADC_RegularChannelConfig(ADC_TypeDef *adc, uint8_t ch, uint8_t rank, uint8_t time) { (void)adc; (void)ch; (void)rank; (void)time; }
+void ADC_TempSensorVrefintCmd(FunctionalState state) { (void)state; }
+void ADC_DMACmd(ADC_TypeDef *adc, FunctionalState state) { (void)adc; (void)state; }
+void ADC_Cmd(ADC_TypeDef *adc, FunctionalState state) { (void)adc; (void)state; }
+void ADC_ResetCalibration(ADC_TypeDef *adc) { (void)adc; }
+FlagStatus ADC_GetResetCalibrationStatus(ADC_TypeDef *adc) { (void)adc; return RESET; }
+void ADC_StartCalibration(ADC_TypeDef *adc) { (void)adc; }
+FlagStatus ADC_GetCalibrationStatus(ADC_TypeDef *adc) { (void)adc; return RESET; }
+void ADC_SoftwareStartConvCmd(ADC_TypeDef *adc, FunctionalState state) { (void)adc; (void)state; }
+void USART_Init(USART_TypeDef *usart, USART_InitTypeDef *init) { (void)usart; (void)init; }
+void USART_DMACmd(USART_TypeDef *usart, uint16_t req, FunctionalState state) { (void)usart; (void)req; (void)state; }
+void USART_Cmd(USART_TypeDef *usart, FunctionalState state) { (void)usart; (void)state; }
+
+/*******************************************************************/
+// Power-on with a lost backup domain, same order as main()
+void HOST_init(void)
+{
+    PROF_init();
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_4);
+
+    DS3231_init();
+    ADS1115_init();
+    TRACE_init();
+    I2C1_Slave_init();
+}
+
+// One pass of the superloop
+void HOST_poll(void)
+{
+    I2C1_Slave_poll();
+    TRACE_poll();
+}
+
+// RTC second interrupt
+void HOST_second(void)
+{
+    rtc_cnt++;
+    rtc_sec = true;
+    NVIC_SetPendingIRQ(RTC_IRQn);
+}
+
+// Write transaction: the bytes after the address byte, the first one is
+// the register pointer. Without stop the next START is a repeated START.
+bool HOST_write(uint8_t dev, const uint8_t *data, uint32_t len, bool stop)
+{
+    if (!i2c_start(dev, false))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        I2C1->DR = data[i];
+        I2C1->SR1 |= I2C_SR1_RXNE;
+        i2c_update();
+        if (I2C1->SR1 & I2C_SR1_RXNE)
+        {
+            host_error("write byte %u not taken", (unsigned)i);
+            I2C1->SR1 &= ~I2C_SR1_RXNE;
+        }
+        if (host_byte_hook != NULL)
+        {
+            host_byte_hook(i);
+        }
+    }
+
+    if (stop)
+    {
+        HOST_stop();
+    }
+
+    return true;
+}
+
+// Read transaction from the current register pointer, the master NACKs
+// the last byte and ends with STOP (no STOPF after the NACK)
+bool HOST_read(uint8_t dev, uint8_t *data, uint32_t len)
+{
+    if (!i2c_start(dev, true))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (I2C1->SR1 & I2C_SR1_TXE)
+        {
+            // The slave would stretch SCL forever
+            host_error("read byte %u not loaded", (unsigned)i);
+            break;
+        }
+        data[i] = (uint8_t)I2C1->DR;
+
+        // DR goes to the shift register, the slave loads the next byte
+        I2C1->SR1 |= I2C_SR1_TXE;
+        i2c_update();
+        if (host_byte_hook != NULL)
+        {
+            host_byte_hook(i);
+        }
+    }
+
+    I2C1->SR1 |= I2C_SR1_AF;
+    i2c_update();
+    if (I2C1->SR1 & I2C_SR1_AF)
+    {
+        host_error("AF not cleared");
+    }
+
+    // The byte left in DR is dropped with the end of the transfer
+    I2C1->SR1 = 0;
+    I2C1->SR2 = 0;
+
+    return true;
+}
+
+// STOP after a write
+void HOST_stop(void)
+{
+    I2C1->SR1 |= I2C_SR1_STOPF;
+    i2c_update();
+    I2C1->SR2 = 0;
+}
+
+/*******************************************************************/
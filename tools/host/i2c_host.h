@@ -0,0 +1,33 @@
+// Host model of I2C1 with its DMA channels, the NVIC and the RTC second for
+// the unchanged firmware sources, driven by a virtual bus master.
+//
+// Each data byte runs the interrupts the slave would see on the chip, in
+// bus order: ADDR, RXNE/TXE (or the DMA request), STOPF, AF on the NACK of
+// the last byte read. The byte in DR is moved to the shift register as the
+// master starts clocking it, so a read always has the next byte loaded
+// when the master NACKs, like the hardware.
+
+#ifndef I2C_HOST_H
+#define I2C_HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32f10x.h"
+
+/*******************************************************************/
+extern uint32_t host_errors;            // Protocol violations of the firmware
+extern uint32_t host_irq_cnt[HOST_IRQ_CNT]; // Handler runs per interrupt
+extern void (*host_byte_hook)(uint32_t n); // After data byte n of a transfer, optional
+
+void HOST_init(void);
+bool HOST_write(uint8_t dev, const uint8_t *data, uint32_t len, bool stop);
+bool HOST_read(uint8_t dev, uint8_t *data, uint32_t len);
+void HOST_stop(void);
+void HOST_poll(void);
+void HOST_second(void);
+bool HOST_i2c_ready(void);
+
+#endif // I2C_HOST_H
+
+/*******************************************************************/
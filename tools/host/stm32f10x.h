@@ -0,0 +1,362 @@
+// Host build of the firmware sources: the device and StdPeriph parts they
+// use. i2c_host.c models I2C1 with its DMA channels and the NVIC, the
+// other peripherals are stubs. test_trace.c has its own trace export.
+
+#ifndef STM32F10X_H
+#define STM32F10X_H
+
+#include <stdint.h>
+
+/*******************************************************************/
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+typedef enum {RESET = 0, SET = !RESET} FlagStatus, ITStatus;
+
+typedef enum
+{
+    RTC_IRQn            = 3,
+    RCC_IRQn            = 5,
+    DMA1_Channel1_IRQn  = 11,
+    DMA1_Channel4_IRQn  = 14,
+    DMA1_Channel6_IRQn  = 16,
+    DMA1_Channel7_IRQn  = 17,
+    TIM2_IRQn           = 28,
+    I2C1_EV_IRQn        = 31,
+    I2C1_ER_IRQn        = 32,
+    HOST_IRQ_CNT,
+} IRQn_Type;
+
+extern uint32_t SystemCoreClock;
+
+// PRIMASK and the NVIC enables gate the interrupts of the model
+void __disable_irq(void);
+void __enable_irq(void);
+#define __DMB()                 __sync_synchronize()
+#define __DSB()                 __sync_synchronize()
+#define __ISB()
+#define __WFI()
+#define __CLZ(x)                ((x) ? (uint32_t)__builtin_clz(x) : 32)
+
+/*******************************************************************/
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    volatile uint16_t CR1;
+    volatile uint16_t CR2;
+    volatile uint16_t DR;
+    volatile uint16_t SR1;
+    volatile uint16_t SR2;
+} I2C_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CCR;
+    volatile uint32_t CNDTR;
+    volatile uint32_t CPAR;
+    volatile uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t ODR;
+    volatile uint32_t BSRR;
+    volatile uint32_t BRR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t BDCR;
+} RCC_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t DR;
+} ADC_TypeDef;
+
+typedef struct
+{
+    volatile uint16_t DR;
+} USART_TypeDef;
+
+typedef struct
+{
+    volatile uint16_t CR1;
+} TIM_TypeDef;
+
+extern CoreDebug_Type *CoreDebug;
+extern DWT_Type *DWT;
+extern I2C_TypeDef *I2C1;
+extern DMA_Channel_TypeDef *DMA1_Channel1, *DMA1_Channel4, *DMA1_Channel6, *DMA1_Channel7;
+extern GPIO_TypeDef *GPIOA, *GPIOB;
+extern RCC_TypeDef *RCC;
+extern ADC_TypeDef *ADC1;
+extern USART_TypeDef *USART1;
+extern TIM_TypeDef *TIM2, *TIM3, *TIM4;
+
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+
+#define I2C_CR1_PE              0x0001
+#define I2C_CR2_ITERREN         0x0100
+#define I2C_CR2_ITEVTEN         0x0200
+#define I2C_CR2_ITBUFEN         0x0400
+#define I2C_CR2_DMAEN           0x0800
+#define I2C_SR1_ADDR            0x0002
+#define I2C_SR1_STOPF           0x0010
+#define I2C_SR1_RXNE            0x0040
+#define I2C_SR1_TXE             0x0080
+#define I2C_SR1_BERR            0x0100
+#define I2C_SR1_AF              0x0400
+#define I2C_SR1_OVR             0x0800
+#define I2C_SR2_BUSY            0x0002
+#define I2C_SR2_TRA             0x0004
+#define I2C_SR2_DUALF           0x0080
+
+#define DMA_CCR_EN              0x0001
+#define DMA_CCR_TCIE            0x0002
+#define DMA_CCR_DIR             0x0010
+
+#define RCC_BDCR_RTCEN          0x8000
+
+/*******************************************************************/
+enum
+{
+    GPIO_Pin_0 = 0x0001, GPIO_Pin_1 = 0x0002, GPIO_Pin_2 = 0x0004, GPIO_Pin_3 = 0x0008,
+    GPIO_Pin_6 = 0x0040, GPIO_Pin_7 = 0x0080, GPIO_Pin_8 = 0x0100, GPIO_Pin_9 = 0x0200,
+    GPIO_Speed_2MHz = 2, GPIO_Speed_50MHz = 3,
+    GPIO_Mode_AIN = 0x00, GPIO_Mode_Out_OD = 0x14, GPIO_Mode_AF_OD = 0x1C, GPIO_Mode_AF_PP = 0x18,
+    GPIO_Remap_I2C1 = 0x02,
+
+    I2C_Mode_I2C = 0x0000, I2C_DutyCycle_16_9 = 0x4000, I2C_Ack_Enable = 0x0400,
+    I2C_AcknowledgedAddress_7bit = 0x4000,
+    I2C_IT_ERR = I2C_CR2_ITERREN, I2C_IT_EVT = I2C_CR2_ITEVTEN, I2C_IT_BUF = I2C_CR2_ITBUFEN,
+
+    DMA_DIR_PeripheralSRC = 0x0000, DMA_DIR_PeripheralDST = DMA_CCR_DIR,
+    DMA_PeripheralInc_Disable = 0x0000, DMA_MemoryInc_Enable = 0x0080,
+    DMA_PeripheralDataSize_Byte = 0x0000, DMA_PeripheralDataSize_HalfWord = 0x0100,
+    DMA_MemoryDataSize_Byte = 0x0000, DMA_MemoryDataSize_HalfWord = 0x0400,
+    DMA_Mode_Normal = 0x0000, DMA_Mode_Circular = 0x0020,
+    DMA_Priority_Low = 0x0000, DMA_Priority_High = 0x2000, DMA_Priority_VeryHigh = 0x3000,
+    DMA_M2M_Disable = 0x0000,
+    DMA_IT_TC = DMA_CCR_TCIE, DMA_IT_HT = 0x0004,
+
+    TIM_CKD_DIV1 = 0, TIM_CounterMode_Up = 0, TIM_OPMode_Single = 0x08, TIM_OPMode_Repetitive = 0,
+    TIM_IT_Update = 0x01, TIM_IT_CC1 = 0x02,
+    TIM_OCMode_PWM1 = 0x60, TIM_OutputState_Enable = 1, TIM_OCPolarity_High = 0,
+
+    ADC_Mode_Independent = 0, ADC_ExternalTrigConv_None = 0xE0000, ADC_DataAlign_Right = 0,
+    ADC_SampleTime_239Cycles5 = 7,
+    ADC_Channel_0 = 0, ADC_Channel_1 = 1, ADC_Channel_2 = 2, ADC_Channel_3 = 3,
+    ADC_Channel_TempSensor = 16,
+
+    USART_WordLength_8b = 0, USART_StopBits_1 = 0, USART_Parity_No = 0,
+    USART_HardwareFlowControl_None = 0, USART_Mode_Tx = 0x08, USART_DMAReq_Tx = 0x80,
+
+    NVIC_PriorityGroup_4 = 0x300,
+    RTC_IT_SEC = 0x01,
+    RCC_IT_LSERDY = 0x02, RCC_LSE_ON = 0x01, RCC_RTCCLKSource_LSE = 0x100, RCC_PCLK2_Div6 = 0x8000,
+};
+
+#define I2C_IT_BERR             ((uint32_t)0x01000100)
+#define I2C_IT_AF               ((uint32_t)0x01000400)
+#define I2C_IT_OVR              ((uint32_t)0x01000800)
+
+#define DMA1_IT_GL1             ((uint32_t)0x00000001)
+#define DMA1_IT_TC1             ((uint32_t)0x00000002)
+#define DMA1_IT_HT1             ((uint32_t)0x00000004)
+#define DMA1_IT_TC4             ((uint32_t)0x00002000)
+#define DMA1_IT_TC6             ((uint32_t)0x00200000)
+#define DMA1_IT_TC7             ((uint32_t)0x02000000)
+
+#define BKP_DR1                 ((uint16_t)0x0004)
+#define BKP_DR2                 ((uint16_t)0x0008)
+#define BKP_DR3                 ((uint16_t)0x000C)
+#define BKP_DR4                 ((uint16_t)0x0010)
+#define BKP_DR5                 ((uint16_t)0x0014)
+#define BKP_DR6                 ((uint16_t)0x0018)
+#define BKP_DR7                 ((uint16_t)0x001C)
+#define BKP_DR8                 ((uint16_t)0x0020)
+#define BKP_DR9                 ((uint16_t)0x0024)
+
+#define RCC_AHBPeriph_DMA1      ((uint32_t)0x00000001)
+#define RCC_APB1Periph_TIM2     ((uint32_t)0x00000001)
+#define RCC_APB1Periph_TIM3     ((uint32_t)0x00000002)
+#define RCC_APB1Periph_TIM4     ((uint32_t)0x00000004)
+#define RCC_APB1Periph_I2C1     ((uint32_t)0x00200000)
+#define RCC_APB1Periph_BKP      ((uint32_t)0x08000000)
+#define RCC_APB1Periph_PWR      ((uint32_t)0x10000000)
+#define RCC_APB2Periph_AFIO     ((uint32_t)0x00000001)
+#define RCC_APB2Periph_GPIOA    ((uint32_t)0x00000004)
+#define RCC_APB2Periph_GPIOB    ((uint32_t)0x00000008)
+#define RCC_APB2Periph_ADC1     ((uint32_t)0x00000200)
+#define RCC_APB2Periph_USART1   ((uint32_t)0x00004000)
+
+/*******************************************************************/
+typedef struct
+{
+    uint16_t GPIO_Pin;
+    int GPIO_Speed;
+    int GPIO_Mode;
+} GPIO_InitTypeDef;
+
+typedef struct
+{
+    uint32_t I2C_ClockSpeed;
+    uint16_t I2C_Mode;
+    uint16_t I2C_DutyCycle;
+    uint16_t I2C_OwnAddress1;
+    uint16_t I2C_Ack;
+    uint16_t I2C_AcknowledgedAddress;
+} I2C_InitTypeDef;
+
+typedef struct
+{
+    uint32_t DMA_PeripheralBaseAddr;
+    uint32_t DMA_MemoryBaseAddr;
+    uint32_t DMA_DIR;
+    uint32_t DMA_BufferSize;
+    uint32_t DMA_PeripheralInc;
+    uint32_t DMA_MemoryInc;
+    uint32_t DMA_PeripheralDataSize;
+    uint32_t DMA_MemoryDataSize;
+    uint32_t DMA_Mode;
+    uint32_t DMA_Priority;
+    uint32_t DMA_M2M;
+} DMA_InitTypeDef;
+
+typedef struct
+{
+    uint16_t TIM_Prescaler;
+    uint16_t TIM_CounterMode;
+    uint16_t TIM_Period;
+    uint16_t TIM_ClockDivision;
+    uint8_t TIM_RepetitionCounter;
+} TIM_TimeBaseInitTypeDef;
+
+typedef struct
+{
+    uint16_t TIM_OCMode;
+    uint16_t TIM_OutputState;
+    uint16_t TIM_Pulse;
+    uint16_t TIM_OCPolarity;
+} TIM_OCInitTypeDef;
+
+typedef struct
+{
+    uint32_t ADC_Mode;
+    FunctionalState ADC_ScanConvMode;
+    FunctionalState ADC_ContinuousConvMode;
+    uint32_t ADC_ExternalTrigConv;
+    uint32_t ADC_DataAlign;
+    uint8_t ADC_NbrOfChannel;
+} ADC_InitTypeDef;
+
+typedef struct
+{
+    uint32_t USART_BaudRate;
+    uint16_t USART_WordLength;
+    uint16_t USART_StopBits;
+    uint16_t USART_Parity;
+    uint16_t USART_Mode;
+    uint16_t USART_HardwareFlowControl;
+} USART_InitTypeDef;
+
+typedef struct
+{
+    uint8_t NVIC_IRQChannel;
+    uint8_t NVIC_IRQChannelPreemptionPriority;
+    uint8_t NVIC_IRQChannelSubPriority;
+    FunctionalState NVIC_IRQChannelCmd;
+} NVIC_InitTypeDef;
+
+/*******************************************************************/
+void NVIC_Init(NVIC_InitTypeDef *init);
+void NVIC_PriorityGroupConfig(uint32_t group);
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+
+void RCC_AHBPeriphClockCmd(uint32_t periph, FunctionalState state);
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state);
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state);
+void RCC_ADCCLKConfig(uint32_t div);
+void RCC_BackupResetCmd(FunctionalState state);
+void RCC_LSEConfig(uint8_t lse);
+void RCC_RTCCLKConfig(uint32_t source);
+void RCC_RTCCLKCmd(FunctionalState state);
+void RCC_ITConfig(uint8_t it, FunctionalState state);
+ITStatus RCC_GetITStatus(uint8_t it);
+void RCC_ClearITPendingBit(uint8_t it);
+
+void GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+void GPIO_PinRemapConfig(uint32_t remap, FunctionalState state);
+
+void I2C_Init(I2C_TypeDef *i2c, I2C_InitTypeDef *init);
+void I2C_Cmd(I2C_TypeDef *i2c, FunctionalState state);
+void I2C_OwnAddress2Config(I2C_TypeDef *i2c, uint8_t adr);
+void I2C_DualAddressCmd(I2C_TypeDef *i2c, FunctionalState state);
+void I2C_ITConfig(I2C_TypeDef *i2c, uint16_t it, FunctionalState state);
+void I2C_DMACmd(I2C_TypeDef *i2c, FunctionalState state);
+void I2C_SendData(I2C_TypeDef *i2c, uint8_t val);
+uint8_t I2C_ReceiveData(I2C_TypeDef *i2c);
+ITStatus I2C_GetITStatus(I2C_TypeDef *i2c, uint32_t it);
+void I2C_ClearITPendingBit(I2C_TypeDef *i2c, uint32_t it);
+
+void DMA_Init(DMA_Channel_TypeDef *ch, DMA_InitTypeDef *init);
+void DMA_Cmd(DMA_Channel_TypeDef *ch, FunctionalState state);
+void DMA_ITConfig(DMA_Channel_TypeDef *ch, uint32_t it, FunctionalState state);
+void DMA_SetCurrDataCounter(DMA_Channel_TypeDef *ch, uint16_t cnt);
+uint16_t DMA_GetCurrDataCounter(DMA_Channel_TypeDef *ch);
+ITStatus DMA_GetITStatus(uint32_t it);
+void DMA_ClearITPendingBit(uint32_t it);
+
+void TIM_TimeBaseInit(TIM_TypeDef *tim, TIM_TimeBaseInitTypeDef *init);
+void TIM_OCStructInit(TIM_OCInitTypeDef *init);
+void TIM_OC1Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init);
+void TIM_OC3Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init);
+void TIM_SetCompare1(TIM_TypeDef *tim, uint16_t val);
+void TIM_SelectOnePulseMode(TIM_TypeDef *tim, uint16_t mode);
+void TIM_Cmd(TIM_TypeDef *tim, FunctionalState state);
+void TIM_ITConfig(TIM_TypeDef *tim, uint16_t it, FunctionalState state);
+ITStatus TIM_GetITStatus(TIM_TypeDef *tim, uint16_t it);
+void TIM_ClearITPendingBit(TIM_TypeDef *tim, uint16_t it);
+
+void ADC_Init(ADC_TypeDef *adc, ADC_InitTypeDef *init);
+void ADC_RegularChannelConfig(ADC_TypeDef *adc, uint8_t ch, uint8_t rank, uint8_t time);
+void ADC_TempSensorVrefintCmd(FunctionalState state);
+void ADC_DMACmd(ADC_TypeDef *adc, FunctionalState state);
+void ADC_Cmd(ADC_TypeDef *adc, FunctionalState state);
+void ADC_ResetCalibration(ADC_TypeDef *adc);
+FlagStatus ADC_GetResetCalibrationStatus(ADC_TypeDef *adc);
+void ADC_StartCalibration(ADC_TypeDef *adc);
+FlagStatus ADC_GetCalibrationStatus(ADC_TypeDef *adc);
+void ADC_SoftwareStartConvCmd(ADC_TypeDef *adc, FunctionalState state);
+
+void PWR_BackupAccessCmd(FunctionalState state);
+uint16_t BKP_ReadBackupRegister(uint16_t reg);
+void BKP_WriteBackupRegister(uint16_t reg, uint16_t val);
+void BKP_SetRTCCalibrationValue(uint8_t val);
+void RTC_WaitForSynchro(void);
+void RTC_WaitForLastTask(void);
+void RTC_SetPrescaler(uint32_t val);
+uint32_t RTC_GetCounter(void);
+void RTC_ITConfig(uint16_t it, FunctionalState state);
+ITStatus RTC_GetITStatus(uint16_t it);
+void RTC_ClearITPendingBit(uint16_t it);
+
+void USART_Init(USART_TypeDef *usart, USART_InitTypeDef *init);
+void USART_DMACmd(USART_TypeDef *usart, uint16_t req, FunctionalState state);
+void USART_Cmd(USART_TypeDef *usart, FunctionalState state);
+
+#endif // STM32F10X_H
+
+/*******************************************************************/
@@ -0,0 +1,168 @@
+// Host test of the I2C slave core on the I2C1 model (i2c_host.c): register
+// round trips of both devices, then the handler cost per byte.
+//
+// Build in tools/ with bash, -DI2C1_DMA=1 for the DMA variant:
+//   gcc -O2 -Wall -no-pie -Wno-pointer-to-int-cast -DTRACE_ENABLE=0 -Ihost -I../source
+//       -o test_i2c_host host/test_i2c_host.c host/i2c_host.c
+//       ../source/{i2c_slave,ds3231*,ads1115*,adc,event_queue,calendar,prof}.c
+//
+// -no-pie keeps the buffers below 4 GB, the firmware hands their addresses
+// to the DMA as 32 bit values.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "i2c_host.h"
+#include "i2c_slave.h"
+#include "ds3231.h"
+#include "ads1115.h"
+
+/*******************************************************************/
+#define TEST_BENCH_READS        200000
+#define TEST_BENCH_LEN          16
+
+static int errors = 0;
+
+static void expect(const char *what, const uint8_t *got, const uint8_t *exp, uint32_t len)
+{
+    if (memcmp(got, exp, len) != 0)
+    {
+        printf("%s:", what);
+        for (uint32_t i = 0; i < len; i++)
+        {
+            printf(" %02X/%02X", got[i], exp[i]);
+        }
+        printf("\n");
+        errors++;
+    }
+}
+
+// Register pointer, then a read after a repeated START
+static void read_regs(uint8_t dev, uint8_t ptr, uint8_t *data, uint32_t len)
+{
+    HOST_write(dev, &ptr, 1, false);
+    HOST_read(dev, data, len);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*******************************************************************/
+static void test_ds3231(void)
+{
+    static const uint8_t set[] = {DS3231_REG_SECONDS, 0x58, 0x59, 0x23, 0x07, 0x31, 0x12, 0x99};
+    static const uint8_t next[] = {0x59, 0x59, 0x23, 0x07, 0x31, 0x12, 0x99};
+    static const uint8_t wrap[] = {0x00, 0x00, 0x00, 0x01, 0x01, 0x81, 0x00};
+    static const uint8_t alarm[] = {DS3231_REG_A1_SECONDS, 0x10, 0x20, 0x30, 0x45, 0x50, 0x60, 0x87};
+    uint8_t buf[16];
+
+    if (!HOST_write(I2CSLAVE_ADDR1, set, sizeof(set), true))
+    {
+        printf("DS3231: address NACK\n");
+        errors++;
+    }
+    // The STOP is committed by the main loop, the tick takes the time
+    HOST_poll();
+    read_regs(I2CSLAVE_ADDR1, DS3231_REG_SECONDS, buf, 7);
+    expect("time set", buf, set + 1, 7);
+
+    HOST_second();
+    read_regs(I2CSLAVE_ADDR1, DS3231_REG_SECONDS, buf, 7);
+    expect("time +1 s", buf, next, 7);
+    HOST_second();
+    read_regs(I2CSLAVE_ADDR1, DS3231_REG_SECONDS, buf, 7);
+    expect("new century", buf, wrap, 7);
+
+    // Not visible before the commit, then all at once
+    HOST_write(I2CSLAVE_ADDR1, alarm, sizeof(alarm), true);
+    read_regs(I2CSLAVE_ADDR1, DS3231_REG_A1_SECONDS, buf, 7);
+    if (buf[0] == alarm[1])
+    {
+        printf("alarm: visible before the commit\n");
+        errors++;
+    }
+    HOST_poll();
+    read_regs(I2CSLAVE_ADDR1, DS3231_REG_A1_SECONDS, buf, 7);
+    expect("alarm", buf, alarm + 1, 7);
+}
+
+static void test_ads1115(void)
+{
+    static const uint8_t cfg[] = {ADS1115_REG_CONFIG, 0x44, 0x83};
+    static const uint8_t lo[] = {ADS1115_REG_LO_THRESH, 0x12, 0x34};
+    static const uint8_t exp_lo[] = {0x12, 0x34, 0x12, 0x34};
+    uint8_t buf[4];
+
+    HOST_write(I2CSLAVE_ADDR2, cfg, sizeof(cfg), true);
+    HOST_write(I2CSLAVE_ADDR2, lo, sizeof(lo), true);
+    HOST_poll();
+
+    // OS reads 0 (converting) in continuous mode
+    read_regs(I2CSLAVE_ADDR2, ADS1115_REG_CONFIG, buf, 2);
+    if (buf[0] != cfg[1] || buf[1] != cfg[2])
+    {
+        printf("config: %02X%02X\n", buf[0], buf[1]);
+        errors++;
+    }
+    // A burst stays in the 16 bit register
+    read_regs(I2CSLAVE_ADDR2, ADS1115_REG_LO_THRESH, buf, 4);
+    expect("Lo_thresh", buf, exp_lo, 4);
+
+    if (HOST_write(0x49, lo, 1, true))
+    {
+        printf("foreign address acknowledged\n");
+        errors++;
+    }
+}
+
+/*******************************************************************/
+// Wall time of the model and the firmware per data byte, and interrupts
+// per byte (one per byte, or per transfer with I2C1_DMA)
+static void bench(void)
+{
+    uint8_t buf[TEST_BENCH_LEN];
+    uint32_t irq0 = 0, irq1 = 0;
+    double t;
+
+    for (int i = 0; i < HOST_IRQ_CNT; i++)
+    {
+        irq0 += host_irq_cnt[i];
+    }
+
+    t = now();
+    for (uint32_t k = 0; k < TEST_BENCH_READS; k++)
+    {
+        read_regs(I2CSLAVE_ADDR1, (uint8_t)k % DS3231_RAM_SIZE, buf, TEST_BENCH_LEN);
+    }
+    t = now() - t;
+
+    for (int i = 0; i < HOST_IRQ_CNT; i++)
+    {
+        irq1 += host_irq_cnt[i];
+    }
+
+    printf("I2C1_DMA %d: %.0f transactions/s, %.1f ns and %.2f interrupts per byte\n",
+           I2C1_DMA, 2 * TEST_BENCH_READS / t, t * 1e9 / TEST_BENCH_READS / (TEST_BENCH_LEN + 1),
+           (double)(irq1 - irq0) / TEST_BENCH_READS / (TEST_BENCH_LEN + 1));
+}
+
+int main(void)
+{
+    HOST_init();
+
+    test_ds3231();
+    test_ads1115();
+    bench();
+
+    errors += host_errors;
+    printf("%s: %d errors\n", errors ? "FAIL" : "OK", errors);
+    return errors != 0;
+}
+
+/*******************************************************************/
@@ -0,0 +1,182 @@
+// Host test of the write event queue (event_queue.c) on the I2C1 model
+// (i2c_host.c): the longest write burst and the most transactions the
+// interrupts can queue while the main loop is stalled without dropping a
+// byte, the abort of a write that did not fit, then the cost of draining
+// the queue in I2C1_Slave_poll. Writes go to the ADS1115 Lo_thresh
+// register, a burst stays in its 16 bits.
+//
+// Build as test_i2c_host.c, with host/test_i2c_queue.c.
+
+#include <stdio.h>
+#include <time.h>
+
+#include "i2c_host.h"
+#include "i2c_slave.h"
+#include "ads1115.h"
+#include "event_queue.h"
+
+/*******************************************************************/
+#define TEST_BURST_MAX          80
+#define TEST_DRAIN_RUNS         100000
+#define TEST_BUS_BYTE_US        22.5    // 9 bits at 400 kHz
+
+static int errors = 0;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void read_lo(uint8_t *reg)
+{
+    uint8_t ptr = ADS1115_REG_LO_THRESH;
+
+    HOST_write(I2CSLAVE_ADDR2, &ptr, 1, false);
+    HOST_read(I2CSLAVE_ADDR2, reg, 2);
+}
+
+// Write of n data bytes to Lo_thresh, reg is the register after it
+static void write_lo(uint32_t n, uint8_t seed, uint8_t *reg)
+{
+    uint8_t data[1 + TEST_BURST_MAX] = {ADS1115_REG_LO_THRESH};
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        data[1 + i] = (uint8_t)(seed + 37 * i);
+        reg[i & 1] = data[1 + i];
+    }
+    HOST_write(I2CSLAVE_ADDR2, data, 1 + n, true);
+}
+
+/*******************************************************************/
+// One write of n bytes with the main loop stalled: all of it or nothing
+static uint32_t burst(void)
+{
+    uint32_t max = 0;
+
+    for (uint32_t n = 1; n <= TEST_BURST_MAX; n++)
+    {
+        uint32_t lost = evq_overflow;
+        uint8_t old[2], exp[2], reg[2];
+
+        read_lo(old);
+        exp[0] = old[0];
+        exp[1] = old[1];
+        write_lo(n, (uint8_t)n, exp);
+        lost = evq_overflow - lost;
+        HOST_poll();
+        read_lo(reg);
+
+        if (lost == 0)
+        {
+            max = n;
+        }
+        else
+        {
+            // Discarded as a whole, the bank keeps the old value
+            exp[0] = old[0];
+            exp[1] = old[1];
+        }
+        if (lost != ((n < EVQ_SIZE) ? 0 : n - (EVQ_SIZE - 1))
+            || reg[0] != exp[0] || reg[1] != exp[1])
+        {
+            printf("burst %u: %u lost, Lo_thresh %02X%02X, expected %02X%02X\n",
+                   (unsigned)n, (unsigned)lost, reg[0], reg[1], exp[0], exp[1]);
+            errors++;
+        }
+    }
+
+    if (evq_level_max > EVQ_SIZE)
+    {
+        printf("queue level %u\n", evq_level_max);
+        errors++;
+    }
+
+    return max;
+}
+
+// Writes of n bytes queued until the first drop, the last complete one
+// is committed
+static uint32_t transactions(uint32_t n)
+{
+    uint32_t lost = evq_overflow;
+    uint32_t cnt = 0;
+    uint8_t exp[2], last[2], reg[2];
+
+    read_lo(exp);
+    for (;;)
+    {
+        last[0] = exp[0];
+        last[1] = exp[1];
+        write_lo(n, (uint8_t)(n + cnt), exp);
+        if (evq_overflow != lost)
+        {
+            break;
+        }
+        cnt++;
+    }
+    HOST_poll();
+    read_lo(reg);
+
+    if (cnt != EVQ_SIZE / (n + 1) || reg[0] != last[0] || reg[1] != last[1])
+    {
+        printf("%u byte writes: %u queued, Lo_thresh %02X%02X, expected %02X%02X\n",
+               (unsigned)n, (unsigned)cnt, reg[0], reg[1], last[0], last[1]);
+        errors++;
+    }
+
+    return cnt;
+}
+
+/*******************************************************************/
+// Main loop cost per queued item, a full queue each time
+static void drain(void)
+{
+    uint8_t exp[2];
+    double t_wr = 0, t_poll = 0, t;
+
+    for (uint32_t k = 0; k < TEST_DRAIN_RUNS; k++)
+    {
+        t = now();
+        write_lo(EVQ_SIZE - 1, (uint8_t)k, exp);
+        t_wr += now() - t;
+        t = now();
+        HOST_poll();
+        t_poll += now() - t;
+    }
+
+    printf("I2C1_DMA %d: %.1f ns per written byte in the interrupts, %.1f ns per item in the main loop\n",
+           I2C1_DMA, t_wr * 1e9 / TEST_DRAIN_RUNS / EVQ_SIZE,
+           t_poll * 1e9 / TEST_DRAIN_RUNS / EVQ_SIZE);
+}
+
+int main(void)
+{
+    uint32_t max;
+
+    HOST_init();
+
+    max = burst();
+    printf("I2C1_DMA %d: %u bytes per write without a drop, main loop may stall %.2f ms at 400 kHz\n",
+           I2C1_DMA, (unsigned)max, max * TEST_BUS_BYTE_US * 1e-3);
+
+    for (uint32_t n = 1; n <= ADS1115_RAM_SIZE; n *= 2)
+    {
+        uint32_t cnt = transactions(n);
+
+        // Address, pointer and data bytes, about one byte time for START and STOP
+        printf("I2C1_DMA %d: %u writes of %u bytes between two polls, main loop may stall %.2f ms\n",
+               I2C1_DMA, (unsigned)cnt, (unsigned)n, cnt * (n + 3) * TEST_BUS_BYTE_US * 1e-3);
+    }
+
+    drain();
+
+    errors += host_errors;
+    printf("%s: %d errors\n", errors ? "FAIL" : "OK", errors);
+    return errors != 0;
+}
+
+/*******************************************************************/
@@ -0,0 +1,272 @@
+// Host stress test of the time latched on START (DS3231_start) on the I2C1
+// model (i2c_host.c): a bus master in a SIGALRM handler reads 0x00...0x06
+// while the main context runs the RTC tick back to back, so reads land
+// inside the tick at random points. Then ticks between the bytes of a read.
+// Every read must be exactly the time at its START or one tick later (a
+// tick in progress may have published already), never older than the
+// read before. Runs across the century, leap day and month rollovers.
+//
+// Build as test_i2c_host.c, with host/test_i2c_tearing.c.
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "i2c_host.h"
+#include "i2c_slave.h"
+#include "ds3231.h"
+#include "calendar.h"
+
+/*******************************************************************/
+#define TEST_TIMER_US           20      // Period of the master
+#define TEST_PHASE_TICKS        200000  // Seconds per start time
+#define TEST_PHASE_READS        50000   // At least, the phase runs longer
+#define TEST_BYTE_READS         1000
+
+typedef struct
+{
+    uint8_t year;           // 0...199, century bit for 100...
+    uint8_t month;
+    uint8_t date;
+    uint8_t day;
+    uint32_t sec;           // of the day
+} TEST_START_t;
+
+static const TEST_START_t test_start[] =
+{
+    { 99, 12, 31, 7, 86390},    // Century
+    {100,  2, 28, 1, 86390},    // Leap day
+    {123,  6, 30, 3, 86395},    // 30 day month
+};
+
+static int errors = 0;
+
+// Phase state, written by main with the master blocked
+static uint32_t phase_days;
+static uint32_t phase_sec;
+static uint8_t phase_day;
+
+// Shared with the master
+static volatile sig_atomic_t ticks;     // Completed in the phase
+static volatile sig_atomic_t in_tick;   // Main is in HOST_second
+static volatile uint32_t reads, reads_tick, reads_masked;
+static volatile uint32_t last_k;
+static volatile uint32_t bad_cnt;
+static uint8_t bad_time[DS3231_TIME_SIZE];
+static uint32_t bad_ticks;
+
+/*******************************************************************/
+// Registers 0x00...0x06 at k seconds into the phase, 24 hour mode
+static void encode(uint32_t k, uint8_t *time)
+{
+    uint32_t sec = phase_sec + k;
+    uint32_t days = phase_days + sec / 86400;
+    uint8_t year, month, date;
+
+    sec %= 86400;
+    CALENDAR_date(days, &year, &month, &date);
+
+    time[DS3231_REG_SECONDS] = CALENDAR_bin2bcd(sec % 60);
+    time[DS3231_REG_MINUTES] = CALENDAR_bin2bcd(sec / 60 % 60);
+    time[DS3231_REG_HOURS] = CALENDAR_bin2bcd(sec / 3600);
+    time[DS3231_REG_DAY] = (phase_day - 1 + (days - phase_days)) % 7 + 1;
+    time[DS3231_REG_DATE] = CALENDAR_bin2bcd(date);
+    time[DS3231_REG_MONTH] = CALENDAR_bin2bcd(month) | ((year >= 100) ? DS3231_MONTH_CENTURY : 0);
+    time[DS3231_REG_YEAR] = CALENDAR_bin2bcd(year % 100);
+}
+
+// Seconds into the phase the read time is, ~0 if it is none of k0, k0 + 1
+static uint32_t match(const uint8_t *time, uint32_t k0)
+{
+    uint8_t exp[DS3231_TIME_SIZE];
+
+    for (uint32_t k = k0; k <= k0 + 1; k++)
+    {
+        encode(k, exp);
+        if (memcmp(time, exp, DS3231_TIME_SIZE) == 0)
+        {
+            return k;
+        }
+    }
+    return ~0u;
+}
+
+static void read_time(uint8_t *time, void (*hook)(uint32_t n))
+{
+    uint8_t ptr = DS3231_REG_SECONDS;
+
+    HOST_write(I2CSLAVE_ADDR1, &ptr, 1, false);
+    host_byte_hook = hook;
+    HOST_read(I2CSLAVE_ADDR1, time, DS3231_TIME_SIZE);
+    host_byte_hook = NULL;
+}
+
+// Bus master, preempts the main context like the I2C interrupt
+static void master(int sig)
+{
+    uint8_t time[DS3231_TIME_SIZE];
+    uint32_t k0 = ticks;
+    bool tick = in_tick;
+    uint32_t k;
+
+    (void)sig;
+    if (!HOST_i2c_ready())
+    {
+        reads_masked++;
+        return;
+    }
+
+    read_time(time, NULL);
+    k = match(time, k0);
+    if (k == ~0u || k < last_k)
+    {
+        if (bad_cnt++ == 0)
+        {
+            memcpy(bad_time, time, sizeof(bad_time));
+            bad_ticks = k0;
+        }
+        return;
+    }
+
+    last_k = k;
+    reads++;
+    reads_tick += tick;
+}
+
+static void block(bool on)
+{
+    sigset_t set;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    sigprocmask(on ? SIG_BLOCK : SIG_UNBLOCK, &set, NULL);
+}
+
+/*******************************************************************/
+// Time written by the master, committed by the main loop
+static void set_time(const TEST_START_t *start)
+{
+    uint8_t set[1 + DS3231_TIME_SIZE] = {DS3231_REG_SECONDS};
+    uint8_t time[DS3231_TIME_SIZE];
+
+    phase_days = CALENDAR_days(start->year, start->month, start->date);
+    phase_sec = start->sec;
+    phase_day = start->day;
+    ticks = 0;
+    last_k = 0;
+
+    encode(0, set + 1);
+    HOST_write(I2CSLAVE_ADDR1, set, sizeof(set), true);
+    HOST_poll();
+
+    read_time(time, NULL);
+    if (match(time, 0) != 0)
+    {
+        printf("time not set for %03u-%02u-%02u\n", start->year, start->month, start->date);
+        errors++;
+    }
+}
+
+static void print_bad(const char *what, const uint8_t *time, uint32_t k0)
+{
+    uint8_t exp[DS3231_TIME_SIZE];
+
+    encode(k0, exp);
+    printf("%s at tick %u:", what, (unsigned)k0);
+    for (uint32_t i = 0; i < DS3231_TIME_SIZE; i++)
+    {
+        printf(" %02X/%02X", time[i], exp[i]);
+    }
+    printf("\n");
+    errors++;
+}
+
+static void stress(const TEST_START_t *start)
+{
+    struct itimerval timer = {{0, TEST_TIMER_US}, {0, TEST_TIMER_US}};
+    struct itimerval off = {{0, 0}, {0, 0}};
+
+    block(true);
+    set_time(start);
+    reads = reads_tick = reads_masked = 0;
+    bad_cnt = 0;
+
+    setitimer(ITIMER_REAL, &timer, NULL);
+    block(false);
+    while (ticks < TEST_PHASE_TICKS || reads < TEST_PHASE_READS)
+    {
+        in_tick = true;
+        HOST_second();
+        in_tick = false;
+        ticks++;
+        HOST_poll();
+    }
+    block(true);
+    setitimer(ITIMER_REAL, &off, NULL);
+
+    printf("I2C1_DMA %d %03u-%02u-%02u: %u s, %u reads, %u in the tick, %u masked\n",
+           I2C1_DMA, start->year, start->month, start->date, (unsigned)ticks,
+           (unsigned)reads, (unsigned)reads_tick, (unsigned)reads_masked);
+    if (bad_cnt != 0)
+    {
+        printf("%u torn reads\n", (unsigned)bad_cnt);
+        print_bad("first", bad_time, bad_ticks);
+    }
+    if (reads_tick == 0)
+    {
+        printf("no read inside the tick\n");
+        errors++;
+    }
+}
+
+/*******************************************************************/
+// Ticks between the bytes of a read do not change it
+static void byte_tick(uint32_t n)
+{
+    (void)n;
+    HOST_second();
+    ticks++;
+}
+
+static void between_bytes(const TEST_START_t *start)
+{
+    uint8_t time[DS3231_TIME_SIZE];
+
+    set_time(start);
+    for (uint32_t i = 0; i < TEST_BYTE_READS; i++)
+    {
+        uint32_t k0 = ticks;
+
+        read_time(time, byte_tick);
+        if (match(time, k0) != k0)
+        {
+            print_bad("ticks between bytes", time, k0);
+            break;
+        }
+    }
+}
+
+int main(void)
+{
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = master;
+    sigaction(SIGALRM, &sa, NULL);
+
+    block(true);
+    HOST_init();
+
+    for (uint32_t i = 0; i < sizeof(test_start) / sizeof(test_start[0]); i++)
+    {
+        stress(&test_start[i]);
+        between_bytes(&test_start[i]);
+    }
+
+    errors += host_errors;
+    printf("%s: %d errors\n", errors ? "FAIL" : "OK", errors);
+    return errors != 0;
+}
+
+/*******************************************************************/
@@ -0,0 +1,137 @@
+// Host test of the register pointer rules on the I2C1 model (i2c_host.c):
+// reads of up to 512 bytes from every start of both banks, then the
+// pointer left by the NACK, with and without I2C1_DMA.
+//
+// Build as test_i2c_host.c, with host/test_i2c_wrap.c.
+
+#include <stdio.h>
+
+#include "i2c_host.h"
+#include "i2c_slave.h"
+#include "ds3231.h"
+#include "ads1115.h"
+#include "prof.h"
+
+/*******************************************************************/
+#define TEST_LEN_MAX            512
+
+static int errors = 0;
+#if (PROF_ENABLE != 0)
+static PROF_PAGE_t prof_start;          // Statistics at the START of the read
+#endif
+
+// Device rules, independent of add_i2c1_adr: the DS3231 wraps from 0x12
+// to 0x00 (and from 0xFF), the ADS1115 stays in the 16 bit register
+static uint8_t next_adr(I2C1_DEV_t dev, uint8_t adr)
+{
+    if (dev == I2C1_DEV_DS3231)
+    {
+        return (adr == DS3231_RAM_SIZE - 1) ? 0 : (uint8_t)(adr + 1);
+    }
+    return (adr & ~1) | ((adr + 1) & 1);
+}
+
+// Byte at an address, the PROF window is the state at START
+static uint8_t value(I2C1_DEV_t dev, uint8_t adr)
+{
+    if (dev == I2C1_DEV_ADS1115)
+    {
+        return ads1115_ram[adr];
+    }
+    if (adr < DS3231_RAM_SIZE)
+    {
+        return ds3231_ram[adr];
+    }
+#if (PROF_ENABLE != 0)
+    if (adr >= PROF_REG_BASE)
+    {
+        adr -= PROF_REG_BASE;
+        return (adr < sizeof(prof_start)) ? ((const uint8_t *)&prof_start)[adr] : 0xFF;
+    }
+#endif
+    return 0xFF;
+}
+
+static void check(I2C1_DEV_t dev, uint8_t ptr, uint32_t len)
+{
+    uint8_t dev_adr = (dev == I2C1_DEV_DS3231) ? I2CSLAVE_ADDR1 : I2CSLAVE_ADDR2;
+    uint8_t start = (dev == I2C1_DEV_DS3231) ? ptr : (uint8_t)(ptr << 1);
+    uint8_t buf[TEST_LEN_MAX];
+    uint8_t adr = start;
+    uint8_t more;
+    uint32_t i;
+
+    HOST_write(dev_adr, &ptr, 1, false);
+#if (PROF_ENABLE != 0)
+    prof_start = prof_page;
+#endif
+    HOST_read(dev_adr, buf, len);
+
+    for (i = 0; i < len; i++)
+    {
+        if (buf[i] != value(dev, adr))
+        {
+            break;
+        }
+        adr = next_adr(dev, adr);
+    }
+
+    // The next read goes on after the last byte the master has taken
+    if (i == len)
+    {
+#if (PROF_ENABLE != 0)
+        prof_start = prof_page;
+#endif
+        HOST_read(dev_adr, &more, 1);
+        if (i2c1_bank[dev].adr != next_adr(dev, adr) || more != value(dev, adr))
+        {
+            i = len + 1;
+        }
+    }
+
+    if (i != len)
+    {
+        printf("I2C1_DMA %d dev %d start 0x%02X len %3u: ", I2C1_DMA, dev, start, (unsigned)len);
+        if (i < len)
+        {
+            printf("byte %u is 0x%02X, expected 0x%02X at 0x%02X\n",
+                   (unsigned)i, buf[i], value(dev, adr), adr);
+        }
+        else
+        {
+            printf("pointer 0x%02X after 0x%02X, expected 0x%02X\n",
+                   i2c1_bank[dev].adr, more, next_adr(dev, adr));
+        }
+        errors++;
+    }
+}
+
+int main(void)
+{
+    HOST_init();
+
+    // Every pointer, burst lengths around the ends of the map and 512 bytes
+    for (uint32_t ptr = 0; ptr <= 0xFF; ptr++)
+    {
+        for (uint32_t len = 1; len <= 3 * DS3231_RAM_SIZE + 1; len++)
+        {
+            check(I2C1_DEV_DS3231, (uint8_t)ptr, len);
+        }
+        check(I2C1_DEV_DS3231, (uint8_t)ptr, TEST_LEN_MAX);
+    }
+
+    for (uint32_t ptr = 0; ptr <= ADS1115_PTR_MASK; ptr++)
+    {
+        for (uint32_t len = 1; len <= 5; len++)
+        {
+            check(I2C1_DEV_ADS1115, (uint8_t)ptr, len);
+        }
+        check(I2C1_DEV_ADS1115, (uint8_t)ptr, TEST_LEN_MAX);
+    }
+
+    errors += host_errors;
+    printf("%s: %d errors\n", errors ? "FAIL" : "OK", errors);
+    return errors != 0;
+}
+
+/*******************************************************************/
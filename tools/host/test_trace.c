@@ -0,0 +1,154 @@
+// Host driver of the bus trace (source/trace.c), see tools/test_trace.py
+//
+// Feeds pseudo random transactions, idle gaps and an export stall into
+// the trace, writes the export stream to stdout and the transactions to
+// the reference file, one per line:
+//   cycles since TRACE_init, device, read, pointer, length, error, data...
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "stm32f10x.h"
+#include "trace.h"
+
+/*******************************************************************/
+#define TEST_RECORDS            20000
+#define TEST_STALL_FIRST        12000  // TRACE_poll is not called, the ring overruns
+#define TEST_STALL_LAST         15000
+#define TEST_IDLE_EVERY         5000   // Idle gap of 5e9 cycles (over a counter turn), polled after 2^31
+
+static CoreDebug_Type core_debug;
+static DWT_Type dwt;
+static USART_TypeDef usart1;
+static DMA_Channel_TypeDef dma1_channel4;
+
+CoreDebug_Type *CoreDebug = &core_debug;
+DWT_Type *DWT = &dwt;
+USART_TypeDef *USART1 = &usart1;
+DMA_Channel_TypeDef *DMA1_Channel4 = &dma1_channel4;
+GPIO_TypeDef *GPIOA;
+
+static const uint8_t *dma_mem;
+static uint32_t rnd_state = 1;
+
+void DMA1_Channel4_IRQHandler(void);
+
+/*******************************************************************/
+// The DMA sends the frame at once and ends with the interrupt
+void DMA_Init(DMA_Channel_TypeDef *ch, DMA_InitTypeDef *init)
+{
+    (void)ch;
+    dma_mem = (const uint8_t *)(uintptr_t)init->DMA_MemoryBaseAddr;
+}
+
+void DMA_SetCurrDataCounter(DMA_Channel_TypeDef *ch, uint16_t cnt)
+{
+    ch->CNDTR = cnt;
+}
+
+void DMA_Cmd(DMA_Channel_TypeDef *ch, FunctionalState state)
+{
+    if (state == ENABLE && ch->CNDTR != 0)
+    {
+        fwrite(dma_mem, 1, ch->CNDTR, stdout);
+        ch->CNDTR = 0;
+        DMA1_Channel4_IRQHandler();
+    }
+}
+
+void GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init) { (void)port; (void)init; }
+void USART_Init(USART_TypeDef *usart, USART_InitTypeDef *init) { (void)usart; (void)init; }
+void USART_DMACmd(USART_TypeDef *usart, uint16_t req, FunctionalState state) { (void)usart; (void)req; (void)state; }
+void USART_Cmd(USART_TypeDef *usart, FunctionalState state) { (void)usart; (void)state; }
+void DMA_ITConfig(DMA_Channel_TypeDef *ch, uint32_t it, FunctionalState state) { (void)ch; (void)it; (void)state; }
+void DMA_ClearITPendingBit(uint32_t it) { (void)it; }
+void NVIC_Init(NVIC_InitTypeDef *init) { (void)init; }
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_AHBPeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void __disable_irq(void) {}
+void __enable_irq(void) {}
+
+/*******************************************************************/
+// Same sequence on every host
+static uint32_t rnd(uint32_t range)
+{
+    rnd_state = rnd_state * 1103515245 + 12345;
+    return (rnd_state >> 8) % range;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *ref;
+    uint64_t t = 1000;
+    uint64_t t0 = t;
+
+    if (argc != 2 || (ref = fopen(argv[1], "w")) == NULL)
+    {
+        fprintf(stderr, "usage: test_trace REFERENCE > DUMP\n");
+        return 2;
+    }
+
+    dwt.CYCCNT = (uint32_t)t;
+    TRACE_init();
+
+    for (uint32_t k = 0; k < TEST_RECORDS; k++)
+    {
+        uint8_t dev = rnd(2);
+        bool read = rnd(2);
+        uint8_t ptr = rnd(4);
+        uint32_t len = (rnd(50) == 0) ? 300 : rnd(20);
+        uint8_t err = (rnd(30) == 0) ? TRACE_ERR_BERR : 0;
+        bool unsent = read && len != 0 && rnd(4) == 0;
+
+        t += 500 + rnd(200000);
+        if (k % TEST_IDLE_EVERY == TEST_IDLE_EVERY - 1)
+        {
+            dwt.CYCCNT = (uint32_t)(t + 0x80000000 + 1000);
+            TRACE_poll();
+            t += 5000000000ull;
+        }
+        dwt.CYCCNT = (uint32_t)t;
+
+        TRACE_start(dev, read, ptr);
+        for (uint32_t i = 0; i < len; i++)
+        {
+            TRACE_byte((uint8_t)(i * 37 + k));
+        }
+        if (unsent)
+        {
+            TRACE_unsent();
+            len--;
+        }
+        if (err)
+        {
+            TRACE_error(err);
+        }
+        dwt.CYCCNT += 100;
+        TRACE_end();
+
+        fprintf(ref, "%llu %u %u %u %u %u", (unsigned long long)(t - t0), dev, read, ptr,
+                (unsigned)(len > 255 ? 255 : len), err);
+        for (uint32_t i = 0; i < len && i < TRACE_DATA; i++)
+        {
+            fprintf(ref, " %02X", (uint8_t)(i * 37 + k));
+        }
+        fprintf(ref, "\n");
+
+        if (k < TEST_STALL_FIRST || k > TEST_STALL_LAST)
+        {
+            dwt.CYCCNT = (uint32_t)(t + 200);
+            TRACE_poll();
+        }
+    }
+
+    // Drain the ring
+    for (uint32_t i = 0; i < TRACE_SIZE; i++)
+    {
+        TRACE_poll();
+    }
+
+    fclose(ref);
+    return 0;
+}
+
+/*******************************************************************/
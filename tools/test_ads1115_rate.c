@@ -0,0 +1,60 @@
+// Host test of the ADS1115 conversion cadence (source/ads1115_rate.c)
+// gcc -O2 -Wall -I../source -o test_ads1115_rate test_ads1115_rate.c ../source/ads1115_rate.c
+
+#include <stdio.h>
+
+#include "ads1115.h"
+
+/*******************************************************************/
+// Data rates of the datasheet in SPS
+static const uint16_t sps[8] = {8, 16, 32, 64, 128, 250, 475, 860};
+
+int main(void)
+{
+    static const uint32_t clocks[] = {8000000, 24000000, 36000000, 48000000, 64000000, 72000000};
+    int errors = 0;
+    unsigned dr, c;
+
+    for (c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++)
+    {
+        for (dr = 0; dr < 8; dr++)
+        {
+            // The other config bits must not matter
+            uint16_t cfg = (ADS1115_CONFIG_DEFAULT & ~(0x07 << ADS1115_CONFIG_DR_Pos))
+                         | (dr << ADS1115_CONFIG_DR_Pos);
+            ADS1115_RATE_t rate;
+            uint32_t psc, ticks;
+            double frq, err, pulse_us;
+            int e = 0;
+
+            if (ADS1115_sps(cfg) != sps[dr] || ADS1115_sps(~cfg & 0xFFFF) != sps[7 - dr]) e++;
+
+            ADS1115_rate_cfg(cfg, clocks[c], &rate);
+            psc = rate.psc + 1;
+            ticks = psc * (rate.period + 1);
+            frq = (double)clocks[c] / ticks;
+            err = (frq - sps[dr]) / sps[dr];
+            pulse_us = rate.pulse * psc * 1e6 / clocks[c];
+
+            // Smallest prescaler, never slower than the data rate and at
+            // most one timer tick per conversion fast
+            if (rate.psc > 0 && clocks[c] / sps[dr] / rate.psc <= 0x10000) e++;
+            if (err < 0 || err * (rate.period + 1) > 1) e++;
+            // Conversion ready pulse: 8 us, up to two timer ticks longer
+            if (pulse_us < 8 || pulse_us > 8 + 2e6 * psc / clocks[c]) e++;
+            if (rate.pulse == 0 || rate.pulse >= rate.period) e++;
+
+            if (e)
+            {
+                printf("%u Hz DR %u: psc %u period %u pulse %u, %.3f SPS, %.2f us\n",
+                       (unsigned)clocks[c], dr, rate.psc, rate.period, rate.pulse, frq, pulse_us);
+                errors += e;
+            }
+        }
+    }
+
+    printf("%s: %d errors\n", errors ? "FAIL" : "OK", errors);
+    return errors != 0;
+}
+
+/*******************************************************************/
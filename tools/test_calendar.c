@@ -0,0 +1,140 @@
+// Exhaustive host test of the calendar conversions (source/calendar.c) and
+// of the one second step of the time registers (source/ds3231_time.c)
+// gcc -O2 -Wall -I../source -o test_calendar test_calendar.c ../source/calendar.c ../source/ds3231_time.c
+//
+// Every date of the year range against a day by day count, every 32 bit
+// second count against divisions and a century of one second steps over
+// 2099 -> 2100 against the conversions, about a minute. The cycles per
+// conversion on the target are measured by PROF_init (source/prof.h).
+
+#include <stdio.h>
+
+#include "calendar.h"
+#include "ds3231.h"
+
+/*******************************************************************/
+static const uint8_t month_len[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+static int errors;
+
+static void fail(const char *what, uint32_t val)
+{
+    if (errors++ < 10)
+    {
+        printf("%s %lu\n", what, (unsigned long)val);
+    }
+}
+
+// Time registers of a day count (years 0...199) at hms
+static void registers(uint32_t days, uint8_t day_ofs, const uint8_t *hms, uint8_t *time)
+{
+    uint8_t year, month, date;
+
+    CALENDAR_date(days, &year, &month, &date);
+
+    time[DS3231_REG_SECONDS] = CALENDAR_bin2bcd(hms[0]);
+    time[DS3231_REG_MINUTES] = CALENDAR_bin2bcd(hms[1]);
+    time[DS3231_REG_HOURS] = CALENDAR_bin2bcd(hms[2]);
+    time[DS3231_REG_DAY] = CALENDAR_weekday(days + day_ofs) + 1;
+    time[DS3231_REG_DATE] = CALENDAR_bin2bcd(date);
+    time[DS3231_REG_MONTH] = CALENDAR_bin2bcd(month) | ((year >= 100) ? DS3231_MONTH_CENTURY : 0);
+    time[DS3231_REG_YEAR] = CALENDAR_bin2bcd((year >= 100) ? year - 100 : year);
+}
+
+static int compare(const uint8_t *time, const uint8_t *expect)
+{
+    for (uint8_t i = 0; i < DS3231_TIME_SIZE; i++)
+    {
+        if (time[i] != expect[i]) return 1;
+    }
+    return 0;
+}
+
+// 01.01.50 ... 01.01.50 with the century bit one second step at a time
+// like the tick, every second of the first day and every midnight checked
+static void century(void)
+{
+    static const uint8_t midnight[3] = {0, 0, 0};
+    uint32_t first = CALENDAR_days(50, 1, 1);
+    uint32_t last = CALENDAR_days(150, 1, 1);
+    uint8_t time[DS3231_TIME_SIZE];
+    uint8_t expect[DS3231_TIME_SIZE];
+    uint8_t hms[3];
+    // The day register counts on its own, 3 on the first day
+    uint8_t day_ofs = 7 + 2 - CALENDAR_weekday(first);
+
+    registers(first, day_ofs, midnight, time);
+
+    for (uint32_t days = first; days < last; days++)
+    {
+        for (uint32_t sec = 1; sec <= 86400; sec++)
+        {
+            DS3231_time_step(time);
+
+            if (days == first && sec < 86400)
+            {
+                CALENDAR_split(sec, hms);
+                registers(days, day_ofs, hms, expect);
+                if (compare(time, expect)) fail("step", sec);
+            }
+        }
+
+        registers(days + 1, day_ofs, midnight, expect);
+        if (compare(time, expect)) fail("midnight", days + 1);
+    }
+}
+
+/*******************************************************************/
+int main(void)
+{
+    uint32_t days = 0;
+    uint32_t sec = 0;
+
+    // Dates, every 4th year a leap year
+    for (uint8_t year = 0; year < CALENDAR_YEARS; year++)
+    {
+        for (uint8_t month = 1; month <= 12; month++)
+        {
+            uint8_t len = month_len[month] + (month == 2 && (year & 3) == 0);
+
+            for (uint8_t date = 1; date <= len; date++, days++)
+            {
+                uint8_t y, m, d;
+
+                if (CALENDAR_days(year, month, date) != days) fail("days", days);
+
+                CALENDAR_date(days, &y, &m, &d);
+                if (y != year || m != month || d != date) fail("date", days);
+
+                if (CALENDAR_weekday(days) != days % 7) fail("weekday", days);
+            }
+        }
+    }
+
+    // BCD of the register values
+    for (uint8_t bin = 0; bin < 100; bin++)
+    {
+        uint8_t bcd = (uint8_t)((bin / 10) << 4 | (bin % 10));
+
+        if (CALENDAR_bin2bcd(bin) != bcd || CALENDAR_bcd2bin(bcd) != bin) fail("bcd", bin);
+    }
+
+    // Seconds, the whole 32 bit range
+    do
+    {
+        uint8_t hms[3];
+
+        if (CALENDAR_split(sec, hms) != sec / 86400
+            || hms[2] != sec % 86400 / 3600 || hms[1] != sec % 3600 / 60 || hms[0] != sec % 60)
+        {
+            fail("split", sec);
+        }
+    } while (++sec != 0);
+
+    century();
+
+    printf("%s: %lu days, %d errors\n", errors ? "FAIL" : "OK", (unsigned long)days, errors);
+    return errors != 0;
+}
+
+/*******************************************************************/
@@ -0,0 +1,58 @@
+// Host test of the aging offset dither (source/ds3231_cal.c)
+// gcc -O2 -Wall -I../source -o test_ds3231_cal test_ds3231_cal.c ../source/ds3231_cal.c
+
+#include <stdio.h>
+
+#include "ds3231.h"
+
+/*******************************************************************/
+#define DAYS        30
+#define PERIODS     (DAYS * 86400 / 32)  // Calibration periods of 2^20 LSE cycles
+
+int main(void)
+{
+    int errors = 0;
+    int aging;
+
+    for (aging = -128; aging <= 127; aging++)
+    {
+        int32_t cal = DS3231_cal_q16((uint8_t)aging);
+        double target = DS3231_RTC_CAL + aging * 0.1e-6 * (1 << 20);
+        uint32_t acc = 0;
+        uint64_t pulses = 0;
+        double ppm;
+        uint32_t n;
+
+        for (n = 1; n <= PERIODS; n++)
+        {
+            uint8_t step = DS3231_cal_step(&acc, cal);
+
+            // Every period floor or ceil of CAL, never more than one
+            // pulse off the ideal sum
+            if (step != cal >> 16 && step != (cal >> 16) + 1) errors++;
+            pulses += step;
+            if (pulses * 65536 > (uint64_t)cal * n || (uint64_t)cal * n - pulses * 65536 >= 65536)
+            {
+                printf("aging %+4d period %u: %llu pulses\n", aging, (unsigned)n,
+                       (unsigned long long)pulses);
+                errors++;
+                break;
+            }
+        }
+
+        // Mean rate of the RTC second (32767 LSE cycles less the removed
+        // pulses) against the aging offset in ppm, positive is slow
+        ppm = (1.0 - (1.0 - (double)pulses / PERIODS / (1 << 20)) * 32768 / 32767) * 1e6;
+        if (ppm - aging * 0.1 > 0.01 || ppm - aging * 0.1 < -0.01
+            || (double)pulses / PERIODS - target > 0.001 || (double)pulses / PERIODS - target < -0.001)
+        {
+            printf("aging %+4d: %.4f ppm, %.4f CAL\n", aging, ppm, (double)pulses / PERIODS);
+            errors++;
+        }
+    }
+
+    printf("%s: %d errors\n", errors ? "FAIL" : "OK", errors);
+    return errors != 0;
+}
+
+/*******************************************************************/
@@ -0,0 +1,92 @@
+// Host test of the INT/SQW and 32kHz timer settings (source/ds3231_out.c)
+// gcc -O2 -Wall -I../source -o test_ds3231_out test_ds3231_out.c ../source/ds3231_out.c
+
+#include <stdio.h>
+
+#include "ds3231.h"
+
+/*******************************************************************/
+// Settings at 72 MHz: 1 Hz, 1.024, 4.096, 8.192 kHz and 32kHz
+static const DS3231_OUT_t out_72m[5] =
+{
+    {true, 1098, 65513, 32757},
+    {true,    1, 35155, 17578},
+    {true,    0, 17577,  8789},
+    {true,    0,  8788,  4394},
+    {true,    0,  2196,  1098},
+};
+static const uint32_t out_frq[5] = {1, 1024, 4096, 8192, DS3231_32K_FRQ};
+
+static int same(const DS3231_OUT_t *a, const DS3231_OUT_t *b)
+{
+    return a->timer == b->timer && a->psc == b->psc && a->period == b->period && a->pulse == b->pulse;
+}
+
+// Any clock: period in 16 bit, the smallest prescaler, frequency within
+// one timer tick of the target
+static int check(const DS3231_OUT_t *out, uint32_t clock, uint32_t frq)
+{
+    uint32_t ticks = (uint32_t)(out->psc + 1) * (out->period + 1);
+    double err = ((double)clock / ticks - frq) / frq;
+
+    if (!out->timer) return 1;
+    if (out->psc > 0 && clock / frq / out->psc <= 0x10000) return 1;
+    if (out->pulse != (out->period + 1) / 2) return 1;
+    if (err < 0 || err * (out->period + 1) > 1) return 1;
+    return 0;
+}
+
+int main(void)
+{
+    static const uint32_t clocks[] = {8000000, 24000000, 36000000, 48000000, 64000000, 72000000};
+    int errors = 0;
+    unsigned control, en32k, c;
+
+    for (c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++)
+    {
+        for (control = 0; control <= (DS3231_CONTROL_INTCN | DS3231_CONTROL_RS); control++)
+        {
+            for (en32k = 0; en32k < 2; en32k++)
+            {
+                DS3231_OUT_t out[DS3231_OUT_CNT];
+                unsigned rs = (control & DS3231_CONTROL_RS) >> DS3231_CONTROL_RS_Pos;
+                bool sqw = (control & DS3231_CONTROL_INTCN) == 0;
+                int e = 0;
+
+                // Alarm enables and the other bits must not matter
+                DS3231_out_cfg(control | DS3231_CONTROL_A1IE | DS3231_CONTROL_A2IE,
+                               en32k ? DS3231_STATUS_EN32KHZ | DS3231_STATUS_OSF : DS3231_STATUS_BSY,
+                               clocks[c], out);
+
+                // Pin state: timer only if the output is on
+                if (out[DS3231_OUT_SQW].timer != sqw) e++;
+                if (out[DS3231_OUT_32K].timer != (en32k != 0)) e++;
+
+                if (sqw)
+                {
+                    e += check(&out[DS3231_OUT_SQW], clocks[c], out_frq[rs]);
+                    if (clocks[c] == 72000000 && !same(&out[DS3231_OUT_SQW], &out_72m[rs])) e++;
+                }
+                if (en32k)
+                {
+                    e += check(&out[DS3231_OUT_32K], clocks[c], out_frq[4]);
+                    if (clocks[c] == 72000000 && !same(&out[DS3231_OUT_32K], &out_72m[4])) e++;
+                }
+
+                if (e)
+                {
+                    printf("%u Hz control 0x%02X EN32kHz %u: SQW %d %u/%u/%u 32k %d %u/%u/%u\n",
+                           (unsigned)clocks[c], control, en32k,
+                           out[0].timer, out[0].psc, out[0].period, out[0].pulse,
+                           out[1].timer, out[1].psc, out[1].period, out[1].pulse);
+                    errors += e;
+                }
+            }
+        }
+    }
+
+    printf("%s: %d errors\n", errors ? "FAIL" : "OK", errors);
+    return errors != 0;
+}
+
+/*******************************************************************/
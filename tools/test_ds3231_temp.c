@@ -0,0 +1,65 @@
+// Host test of the temperature register conversion (source/ds3231_temp.c)
+// gcc -O2 -Wall -I../source -o test_ds3231_temp test_ds3231_temp.c ../source/ds3231_temp.c
+
+#include <stdio.h>
+
+#include "ds3231.h"
+
+/*******************************************************************/
+// Ideal mean sensor voltage in 1/16 ADC steps at a temperature in quarter C
+static uint16_t adc_of(int quarter)
+{
+    double mv = DS3231_TEMP_V25 - (quarter / 4.0 - 25) * DS3231_TEMP_SLOPE / 1000.0;
+
+    return (uint16_t)(mv * 65536 / 3300 + 0.5);
+}
+
+static int quarter_of(uint16_t reg)
+{
+    return (int16_t)reg >> 6;
+}
+
+int main(void)
+{
+    int errors = 0;
+    int quarter;
+    uint32_t adc;
+    int last;
+
+    // -40 ... +85 C, every LSB of the register
+    for (quarter = -40 * 4; quarter <= 85 * 4; quarter++)
+    {
+        uint16_t reg = DS3231_temp_reg(adc_of(quarter));
+
+        if (reg & 0x3F || quarter_of(reg) != quarter)
+        {
+            printf("%+7.2f C: reg 0x%04X\n", quarter / 4.0, reg);
+            errors++;
+        }
+    }
+
+    // Datasheet examples at the ends of the range
+    if (DS3231_temp_reg(adc_of(-40 * 4)) != 0xD800) errors++;
+    if (DS3231_temp_reg(adc_of(85 * 4)) != 0x5500) errors++;
+
+    // Whole input range: falling with the voltage, clamped, never wraps
+    last = quarter_of(DS3231_temp_reg(0));
+    if (last != 511) errors++;
+    for (adc = 1; adc <= 0xFFFF; adc++)
+    {
+        int q = quarter_of(DS3231_temp_reg((uint16_t)adc));
+
+        if (q > last || q < -512)
+        {
+            printf("adc %5u: %+7.2f C after %+7.2f C\n", (unsigned)adc, q / 4.0, last / 4.0);
+            errors++;
+        }
+        last = q;
+    }
+    if (last != -512) errors++;
+
+    printf("%s: %d errors\n", errors ? "FAIL" : "OK", errors);
+    return errors != 0;
+}
+
+/*******************************************************************/
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""Round trip test of the bus trace: source/trace.c on the host, piped
+through trace_decode.py and compared with the transactions fed in.
+
+    gcc -O1 -no-pie -Wno-pointer-to-int-cast -Ihost -I../source \\
+        -o test_trace host/test_trace.c ../source/trace.c
+    ./test_trace.py ./test_trace
+
+-no-pie keeps the buffers below 4 GB, trace.c hands their addresses to the
+DMA as 32 bit values.
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+CLOCK = 72e6
+TIME_SHIFT = 6  # TRACE_TIME_SHIFT
+DATA = 4        # TRACE_DATA
+
+DEVS = ('DS3231', 'ADS1115')
+ERRS = {'BERR': 0x01, 'OVR': 0x02, 'LOST': 0x04}
+
+
+def reference(path):
+    """Transactions as written by the driver"""
+    recs = []
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            cycles, dev, read, ptr, length, err = (int(x) for x in fields[:6])
+            time = (cycles >> TIME_SHIFT << TIME_SHIFT) / CLOCK
+            recs.append((time, dev, bool(read), ptr, length, fields[6:], err))
+    return recs
+
+
+def decoded(lines):
+    """Segments of (synced, records) between the boot and lost markers"""
+    segments = []
+    for line in lines:
+        if line.startswith('---'):
+            if 'broken' in line:
+                raise ValueError(line)
+            segments.append(('boot' in line, []))
+            continue
+        fields = line[1:].split()
+        time, dev, rw, ptr = fields[:4]
+        assert fields[4] == 'len'
+        length = int(fields[5])
+        data = [x for x in fields[6:] if len(x) == 2 and x != '..']
+        err = sum(ERRS[x] for x in fields[6:] if x in ERRS)
+        segments[-1][1].append((float(time), DEVS.index(dev), rw == 'R',
+                                None if ptr == '?' else int(ptr, 16), length, data, err))
+    return segments
+
+
+def same(rec, ref):
+    _, dev, read, ptr, length, data, err = rec
+    return ((dev, read, length, data, err) == ref[1:3] + ref[4:]
+            and (ptr is None or ptr == ref[3]))
+
+
+def check(segments, refs):
+    """Every segment is a run of the reference, a lost marker may skip
+    records. Times are since boot in synced segments, else relative."""
+    j = 0
+    skipped = 0
+    for synced, recs in segments:
+        if not recs:
+            continue
+        start = j
+        if not synced:
+            while j < len(refs) and not all(
+                    j + i < len(refs) and same(r, refs[j + i]) for i, r in enumerate(recs)):
+                j += 1
+        ofs = 0 if synced else recs[0][0] - refs[j][0]
+        for i, rec in enumerate(recs):
+            if j >= len(refs) or not same(rec, refs[j]):
+                raise ValueError('record %d: %r' % (j, rec))
+            if abs(rec[0] - ofs - refs[j][0]) > 2e-6:
+                raise ValueError('record %d: time %.6f, expected %.6f' % (j, rec[0] - ofs, refs[j][0]))
+            j += 1
+        skipped += j - start - len(recs)
+    if j != len(refs):
+        raise ValueError('%d records missing at the end' % (len(refs) - j))
+    return skipped
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit('usage: test_trace.py DRIVER')
+    decoder = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'trace_decode.py')
+
+    with tempfile.TemporaryDirectory() as tmp:
+        ref = os.path.join(tmp, 'ref.txt')
+        driver = subprocess.Popen([sys.argv[1], ref], stdout=subprocess.PIPE)
+        out = subprocess.run([sys.executable, decoder, '-c', str(CLOCK), '-'],
+                             stdin=driver.stdout, stdout=subprocess.PIPE, check=True)
+        driver.stdout.close()
+        if driver.wait() != 0:
+            sys.exit('driver failed')
+        refs = reference(ref)
+
+    segments = decoded(out.stdout.decode().splitlines())
+    try:
+        if not segments or not segments[0][0]:
+            raise ValueError('no boot frame')
+        skipped = check(segments, refs)
+        if len(segments) < 2 or skipped == 0:
+            raise ValueError('the stall has not overrun the ring')
+    except ValueError as e:
+        sys.exit('FAIL: %s' % e)
+    print('OK: %d records, %d lost in the stall' % (len(refs), skipped))
+
+
+if __name__ == '__main__':
+    main()
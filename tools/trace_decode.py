@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Decoder of the I2C bus trace streamed on USART1 TX, see source/trace.h
+
+    trace_decode.py [-c CLOCK] [-b BAUD] [dump | serial port | -]
+
+Reads a raw dump (or a serial port with pyserial) as a stream and prints
+one line per transaction, so dumps of any size run in constant memory.
+"""
+
+import argparse
+import os
+import sys
+
+TIME_SHIFT = 6  # TRACE_TIME_SHIFT
+DATA = 4        # TRACE_DATA
+
+HDR_READ = 0x80
+HDR_DEV = 0x40
+HDR_ERR = 0x20
+HDR_PTR = 0x10
+HDR_LEN = 0x0F
+
+ERR_IDLE = 0x80
+ERR_NAMES = ((0x01, 'BERR'), (0x02, 'OVR'), (0x04, 'LOST'))
+
+FRAME_LOST = 0x01
+FRAME_BOOT = 0x02
+
+DEVS = ('DS3231', 'ADS1115')
+
+
+def frames(stream):
+    """COBS decoded frames between 0x00 delimiters, broken frames are skipped.
+    The bytes up to the first delimiter are a cut frame unless the capture
+    has started before the boot frame."""
+    buf = bytearray()
+    first = True
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            return
+        for b in chunk:
+            if b != 0:
+                buf.append(b)
+                continue
+            frame = cobs_decode(buf)
+            buf.clear()
+            if frame and (not first or frame[0] & FRAME_BOOT):
+                yield frame
+            first = False
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Decoder:
+    def __init__(self, clock):
+        self.unit = (1 << TIME_SHIFT) / clock
+        self.time = 0
+        self.synced = False   # Time since boot known, nothing lost so far
+        self.ptr = [None, None]
+
+    def lost(self, boot=False):
+        self.time = 0
+        self.synced = boot
+        self.ptr = [None, None]
+
+    def records(self, data):
+        """Transactions of a frame payload as tuples"""
+        i = 0
+        while i < len(data):
+            hdr = data[i]
+            i += 1
+            delta = shift = 0
+            while True:
+                b = data[i]
+                i += 1
+                delta |= (b & 0x7F) << shift
+                shift += 7
+                if not b & 0x80:
+                    break
+            self.time += delta
+            dev = 1 if hdr & HDR_DEV else 0
+            if hdr & HDR_PTR:
+                self.ptr[dev] = data[i]
+                i += 1
+            length = hdr & HDR_LEN
+            if length == HDR_LEN:
+                length = data[i]
+                i += 1
+            err = 0
+            if hdr & HDR_ERR:
+                err = data[i]
+                i += 1
+            n = min(length, DATA)
+            payload = data[i:i + n]
+            i += n
+            if err & ERR_IDLE:
+                continue
+            yield (self.time * self.unit, dev, bool(hdr & HDR_READ), self.ptr[dev],
+                   length, payload, err)
+
+    def format(self, rec):
+        time, dev, read, ptr, length, payload, err = rec
+        line = '%s%12.6f  %-7s %s  %s  len %3d  %-11s' % (
+            ' ' if self.synced else '+', time, DEVS[dev], 'R' if read else 'W',
+            '0x%02X' % ptr if ptr is not None else ' ?  ', length,
+            ' '.join('%02X' % b for b in payload) + (' ..' if length > len(payload) else ''))
+        errs = [name for bit, name in ERR_NAMES if err & bit]
+        if errs:
+            line += '  ' + ' '.join(errs)
+        return line.rstrip()
+
+
+def open_input(name, baud):
+    if name == '-':
+        return sys.stdin.buffer
+    if os.path.isfile(name):
+        return open(name, 'rb')
+    import serial  # pyserial, only for live capture
+    return serial.Serial(name, baud, timeout=None)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('input', nargs='?', default='-', help='dump file, serial port or - (stdin)')
+    parser.add_argument('-c', '--clock', type=float, default=72e6, help='core clock in Hz')
+    parser.add_argument('-b', '--baud', type=int, default=115200, help='TRACE_UART_BAUD')
+    args = parser.parse_args()
+
+    dec = Decoder(args.clock)
+    # Times are since boot from a boot frame on, else relative (+)
+    out = sys.stdout
+    try:
+        for frame in frames(open_input(args.input, args.baud)):
+            if frame[0] & FRAME_BOOT:
+                out.write('--- boot ---\n')
+                dec.lost(boot=True)
+            elif frame[0] & FRAME_LOST:
+                out.write('--- records lost ---\n')
+                dec.lost()
+            try:
+                for rec in dec.records(frame[1:]):
+                    out.write(dec.format(rec) + '\n')
+            except IndexError:
+                out.write('--- broken frame ---\n')
+                dec.lost()
+    except (BrokenPipeError, KeyboardInterrupt):
+        pass
+
+
+if __name__ == '__main__':
+    main()